@@ -0,0 +1,234 @@
+#pragma once
+
+#define S2_USING_ATOM
+
+#include "s2string.h"
+
+#ifndef S2_ATOM_CHUNK_SIZE
+#define S2_ATOM_CHUNK_SIZE 4096
+#endif
+
+namespace s2
+{
+	class atompool;
+
+	// A handle to an interned string. Two atoms from the same pool are equal only if they point to the same text, so
+	// comparing them is a single pointer comparison, and their hash is computed only once when the text is interned.
+	class atom
+	{
+		friend class atompool;
+
+	private:
+		struct entry
+		{
+			uint64_t hash;
+			size_t len;
+
+			inline const char* data() const { return (const char*)(this + 1); }
+		};
+
+		const entry* m_entry = nullptr;
+
+		inline atom(const entry* e) : m_entry(e) {}
+
+	public:
+		inline atom() {}
+
+		inline bool is_null() const { return m_entry == nullptr; }
+		inline const char* c_str() const { return m_entry == nullptr ? "" : m_entry->data(); }
+		inline size_t len() const { return m_entry == nullptr ? 0 : m_entry->len; }
+		inline stringview view() const { return stringview(c_str(), len()); }
+
+		// Returns the same hash as stringview::hash() for the text, which is computed only once when interned.
+		inline uint64_t hash() const { return m_entry == nullptr ? 0 : m_entry->hash; }
+
+		inline bool operator ==(const atom& other) const { return m_entry == other.m_entry; }
+		inline bool operator !=(const atom& other) const { return m_entry != other.m_entry; }
+	};
+
+	// Hasher for using atoms as keys in s2::hashtable and s2::set, which returns the hash that is stored in the atom.
+	class atomhasher
+	{
+	public:
+		static inline uint64_t hash(const atom& key) { return key.hash(); }
+	};
+
+	// Interns strings, so that every distinct text is only stored once. The text of all atoms lives in large chunks that
+	// are only freed when the pool is destroyed, and an open addressing hash index is used to look up existing atoms.
+	// Atoms are only valid for as long as the pool that made them exists. A pool is not thread safe.
+	class atompool
+	{
+	private:
+		struct chunk
+		{
+			chunk* next;
+			size_t size;
+			size_t capacity;
+
+			inline char* data() { return (char*)(this + 1); }
+		};
+
+		chunk* m_chunks = nullptr;
+
+		const atom::entry** m_index = nullptr;
+		size_t m_indexSize = 0;
+		size_t m_length = 0;
+
+	public:
+		atompool();
+		atompool(const atompool& copy) = delete;
+		~atompool();
+
+		// Returns the amount of distinct atoms in the pool.
+		size_t len() const;
+
+		// Returns the atom for the given text, adding it to the pool if it doesn't exist yet.
+		atom intern(const stringview& str);
+
+		// Returns the atom for the given text if it's already in the pool, or a null atom if it isn't.
+		atom find(const stringview& str) const;
+
+		// A pool that lives for the entire duration of the program.
+		static atompool& global();
+
+	private:
+		const atom::entry* allocate_entry(const stringview& str, uint64_t hash);
+		void grow_index();
+	};
+
+	// Interns the given text in the global pool.
+	atom intern(const stringview& str);
+}
+
+#if defined(S2_IMPL)
+s2::atompool::atompool()
+{
+}
+
+s2::atompool::~atompool()
+{
+	chunk* c = m_chunks;
+	while (c != nullptr) {
+		chunk* next = c->next;
+		S2_FREE(c);
+		c = next;
+	}
+	if (m_index != nullptr) {
+		S2_FREE(m_index);
+	}
+}
+
+size_t s2::atompool::len() const
+{
+	return m_length;
+}
+
+s2::atom s2::atompool::intern(const s2::stringview& str)
+{
+	uint64_t hash = str.hash();
+
+	// Keep the index at most half full, so that probe sequences stay short
+	if ((m_length + 1) * 2 > m_indexSize) {
+		grow_index();
+	}
+
+	size_t mask = m_indexSize - 1;
+	size_t i = (size_t)hash & mask;
+	while (m_index[i] != nullptr) {
+		const atom::entry* e = m_index[i];
+		if (e->hash == hash && e->len == str.len() && !memcmp(e->data(), str.c_str(), e->len)) {
+			return atom(e);
+		}
+		i = (i + 1) & mask;
+	}
+
+	const atom::entry* e = allocate_entry(str, hash);
+	m_index[i] = e;
+	m_length++;
+	return atom(e);
+}
+
+s2::atom s2::atompool::find(const s2::stringview& str) const
+{
+	if (m_length == 0) {
+		return atom();
+	}
+
+	uint64_t hash = str.hash();
+
+	size_t mask = m_indexSize - 1;
+	size_t i = (size_t)hash & mask;
+	while (m_index[i] != nullptr) {
+		const atom::entry* e = m_index[i];
+		if (e->hash == hash && e->len == str.len() && !memcmp(e->data(), str.c_str(), e->len)) {
+			return atom(e);
+		}
+		i = (i + 1) & mask;
+	}
+	return atom();
+}
+
+s2::atompool& s2::atompool::global()
+{
+	static atompool pool;
+	return pool;
+}
+
+const s2::atom::entry* s2::atompool::allocate_entry(const s2::stringview& str, uint64_t hash)
+{
+	// Entries are kept aligned so that the header of the next entry can be read directly
+	const size_t align = alignof(atom::entry);
+	size_t size = (sizeof(atom::entry) + str.len() + 1 + align - 1) & ~(align - 1);
+
+	if (m_chunks == nullptr || m_chunks->capacity - m_chunks->size < size) {
+		size_t capacity = size > S2_ATOM_CHUNK_SIZE ? size : S2_ATOM_CHUNK_SIZE;
+		chunk* c = (chunk*)S2_MALLOC(sizeof(chunk) + capacity);
+		c->next = m_chunks;
+		c->size = 0;
+		c->capacity = capacity;
+		m_chunks = c;
+	}
+
+	atom::entry* e = (atom::entry*)(m_chunks->data() + m_chunks->size);
+	m_chunks->size += size;
+
+	e->hash = hash;
+	e->len = str.len();
+	char* text = (char*)(e + 1);
+	memcpy(text, str.c_str(), str.len());
+	text[str.len()] = '\0';
+	return e;
+}
+
+void s2::atompool::grow_index()
+{
+	size_t newSize = m_indexSize == 0 ? 64 : m_indexSize * 2;
+	const atom::entry** newIndex = (const atom::entry**)S2_MALLOC(newSize * sizeof(atom::entry*));
+	memset(newIndex, 0, newSize * sizeof(atom::entry*));
+
+	// Re-insert existing entries with their stored hash
+	size_t mask = newSize - 1;
+	for (size_t i = 0; i < m_indexSize; i++) {
+		const atom::entry* e = m_index[i];
+		if (e == nullptr) {
+			continue;
+		}
+		size_t j = (size_t)e->hash & mask;
+		while (newIndex[j] != nullptr) {
+			j = (j + 1) & mask;
+		}
+		newIndex[j] = e;
+	}
+
+	if (m_index != nullptr) {
+		S2_FREE(m_index);
+	}
+	m_index = newIndex;
+	m_indexSize = newSize;
+}
+
+s2::atom s2::intern(const s2::stringview& str)
+{
+	return atompool::global().intern(str);
+}
+#endif
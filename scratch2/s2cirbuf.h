@@ -6,6 +6,16 @@
 #include <cstdlib>
 #include <cstring>
 
+#ifndef S2_MALLOC
+#define S2_MALLOC(size) ::malloc(size)
+#endif
+#ifndef S2_REALLOC
+#define S2_REALLOC(ptr, size) ::realloc(ptr, size)
+#endif
+#ifndef S2_FREE
+#define S2_FREE(ptr) ::free(ptr)
+#endif
+
 namespace s2
 {
 	enum class cirbufexception
@@ -94,7 +104,7 @@ namespace s2
 			if (capacity == 0) {
 				throw cirbufexception::invalid_capacity;
 			}
-			m_buffer = (uint8_t*)malloc(capacity);
+			m_buffer = (uint8_t*)S2_MALLOC(capacity);
 			m_bufferEnd = m_buffer + capacity;
 			m_capacity = capacity;
 			m_size = 0;
@@ -102,7 +112,7 @@ namespace s2
 		}
 
 		inline cirbuf(const cirbuf&) = delete;
-		inline ~cirbuf() { free(m_buffer); }
+		inline ~cirbuf() { S2_FREE(m_buffer); }
 
 		inline size_t capacity() const { return m_capacity; }
 		inline size_t size() const { return m_size; }
@@ -119,10 +129,10 @@ namespace s2
 				throw cirbufexception::invalid_capacity;
 			}
 
-			auto newBuffer = (uint8_t*)malloc(capacity);
+			auto newBuffer = (uint8_t*)S2_MALLOC(capacity);
 			peek(newBuffer, m_size);
 
-			free(m_buffer);
+			S2_FREE(m_buffer);
 			m_buffer = newBuffer;
 			m_bufferEnd = newBuffer + capacity;
 			m_capacity = capacity;
@@ -7,6 +7,32 @@
 #include <new>
 #include <initializer_list>
 
+#ifndef S2_MALLOC
+#define S2_MALLOC(size) ::malloc(size)
+#endif
+#ifndef S2_REALLOC
+#define S2_REALLOC(ptr, size) ::realloc(ptr, size)
+#endif
+#ifndef S2_FREE
+#define S2_FREE(ptr) ::free(ptr)
+#endif
+
+#ifndef S2_USING_DEFAULT_ALLOCATOR
+#define S2_USING_DEFAULT_ALLOCATOR
+namespace s2
+{
+	// Allocates memory through S2_MALLOC, S2_REALLOC, and S2_FREE. Containers take a class with these same static
+	// functions as a template parameter, which can be used to give specific containers their own memory.
+	class default_allocator
+	{
+	public:
+		static inline void* allocate(size_t size) { return S2_MALLOC(size); }
+		static inline void* reallocate(void* ptr, size_t size) { return S2_REALLOC(ptr, size); }
+		static inline void deallocate(void* ptr) { S2_FREE(ptr); }
+	};
+}
+#endif
+
 #ifndef S2_DICT_ALLOC_STEP
 #define S2_DICT_ALLOC_STEP 16
 #endif
@@ -24,13 +50,14 @@ namespace s2
 		index_out_of_range,
 	};
 
-	template<typename TKey, typename TValue>
+	template<typename TKey, typename TValue, typename TAllocator>
 	class dict;
 
 	template<typename TKey, typename TValue>
 	class dictpair
 	{
-		friend class dict<TKey, TValue>;
+		template<typename, typename, typename>
+		friend class dict;
 
 	private:
 		TKey m_key;
@@ -75,11 +102,11 @@ namespace s2
 		}
 	};
 
-	template<typename TKey, typename TValue>
+	template<typename TKey, typename TValue, typename TAllocator>
 	class dictiterator
 	{
 	private:
-		typedef dict<TKey, TValue> dict_type;
+		typedef dict<TKey, TValue, TAllocator> dict_type;
 
 	private:
 		dict_type* m_dict;
@@ -114,12 +141,12 @@ namespace s2
 		}
 	};
 
-	template<typename TKey, typename TValue>
+	template<typename TKey, typename TValue, typename TAllocator = default_allocator>
 	class dict
 	{
 	public:
 		typedef dictpair<TKey, TValue> pair;
-		typedef dictiterator<TKey, TValue> iterator;
+		typedef dictiterator<TKey, TValue, TAllocator> iterator;
 
 	private:
 		pair* m_pairs;
@@ -157,7 +184,7 @@ namespace s2
 		{
 			clear();
 			if (m_pairs != nullptr) {
-				free(m_pairs);
+				TAllocator::deallocate(m_pairs);
 			}
 		}
 
@@ -359,7 +386,7 @@ namespace s2
 				count += (count % S2_DICT_ALLOC_STEP);
 			}
 
-			m_pairs = (pair*)realloc(m_pairs, count * sizeof(pair));
+			m_pairs = (pair*)TAllocator::reallocate(m_pairs, count * sizeof(pair));
 			m_allocSize = count;
 		}
 
@@ -0,0 +1,494 @@
+#pragma once
+
+#define S2_USING_ENCODING
+
+#include "s2string.h"
+
+namespace s2
+{
+	// Returned by the decoding functions when the input is not valid.
+	static constexpr size_t encoding_error = (size_t)-1;
+
+	// The exact amount of characters that encoding the given amount of bytes produces.
+	constexpr size_t base64_encoded_length(size_t len) { return (len + 2) / 3 * 4; }
+	constexpr size_t hex_encoded_length(size_t len) { return len * 2; }
+
+	// The most bytes that decoding the given amount of characters can produce.
+	constexpr size_t base64_decoded_length(size_t len) { return len / 4 * 3; }
+	constexpr size_t hex_decoded_length(size_t len) { return len / 2; }
+
+	// Encodes into the buffer, which must have room for the encoded length, without a null terminator. Returns the
+	// amount of characters written. Base64 uses the standard alphabet with padding. This uses AVX2 for base64 and SSE2
+	// for hex when available.
+	size_t encode_base64(char* dst, const void* src, size_t len);
+	size_t encode_hex(char* dst, const void* src, size_t len, bool uppercase = false);
+
+	// Decodes into the buffer, which must have room for the decoded length. Returns the amount of bytes written, or
+	// encoding_error if the input is not valid. Validation is strict: base64 must be padded to a multiple of 4 characters,
+	// the unused bits before the padding must be zero, and whitespace is not allowed. Hex digits may be upper or lower
+	// case, and must come in pairs.
+	size_t decode_base64(void* dst, const char* src, size_t len);
+	size_t decode_hex(void* dst, const char* src, size_t len);
+
+	// Appends the encoded text to the string, growing it only once.
+	void encode_base64(string& out, const void* src, size_t len);
+	void encode_hex(string& out, const void* src, size_t len, bool uppercase = false);
+
+	// Appends the decoded bytes to the string, growing it only once. If the input is not valid, this returns false and
+	// the string is left unchanged.
+	bool decode_base64(string& out, const stringview& src);
+	bool decode_hex(string& out, const stringview& src);
+
+	// Calls func(buffer, size, last) for consecutive blocks of the given spans, where every block except the last is a
+	// multiple of blockSize. Bytes that are left over at the end of a span are carried over into the next one. Stops
+	// and returns false as soon as func does.
+	template<typename TSpans, typename TFunc>
+	inline bool encoding_for_blocks(const TSpans& spans, size_t blockSize, TFunc&& func)
+	{
+		uint8_t carry[4];
+		size_t numCarry = 0;
+		for (const auto& span : spans) {
+			const uint8_t* p = (const uint8_t*)span.buffer;
+			size_t size = span.size;
+
+			if (numCarry > 0) {
+				while (numCarry < blockSize && size > 0) {
+					carry[numCarry++] = *p++;
+					size--;
+				}
+				if (numCarry < blockSize) {
+					continue;
+				}
+				if (!func(carry, numCarry, false)) {
+					return false;
+				}
+				numCarry = 0;
+			}
+
+			size_t whole = size / blockSize * blockSize;
+			if (whole > 0 && !func(p, whole, false)) {
+				return false;
+			}
+			for (size_t i = whole; i < size; i++) {
+				carry[numCarry++] = p[i];
+			}
+		}
+		return func(carry, numCarry, true);
+	}
+
+	// These work like the string functions above, but read from a list of spans that each have a buffer and a size, such
+	// as the s2::cirbuf_mapping from s2cirbuf.h, as if they were one continuous buffer.
+	template<typename TSpans>
+	inline void encode_base64_spans(string& out, const TSpans& spans)
+	{
+		encoding_for_blocks(spans, 3, [&out](const uint8_t* p, size_t size, bool) {
+			encode_base64(out, p, size);
+			return true;
+		});
+	}
+
+	template<typename TSpans>
+	inline void encode_hex_spans(string& out, const TSpans& spans, bool uppercase = false)
+	{
+		encoding_for_blocks(spans, 1, [&out, uppercase](const uint8_t* p, size_t size, bool) {
+			encode_hex(out, p, size, uppercase);
+			return true;
+		});
+	}
+
+	template<typename TSpans>
+	inline bool decode_base64_spans(string& out, const TSpans& spans)
+	{
+		size_t oldLen = out.len();
+		bool padded = false;
+		bool ok = encoding_for_blocks(spans, 4, [&out, &padded](const uint8_t* p, size_t size, bool) {
+			// Padding is only allowed at the very end
+			if (size == 0) {
+				return true;
+			}
+			if (padded) {
+				return false;
+			}
+			padded = p[size - 1] == '=';
+			return decode_base64(out, stringview((const char*)p, size));
+		});
+		if (!ok) {
+			out.remove(oldLen, out.len() - oldLen);
+		}
+		return ok;
+	}
+
+	template<typename TSpans>
+	inline bool decode_hex_spans(string& out, const TSpans& spans)
+	{
+		size_t oldLen = out.len();
+		bool ok = encoding_for_blocks(spans, 2, [&out](const uint8_t* p, size_t size, bool) {
+			return decode_hex(out, stringview((const char*)p, size));
+		});
+		if (!ok) {
+			out.remove(oldLen, out.len() - oldLen);
+		}
+		return ok;
+	}
+}
+
+#if defined(S2_IMPL)
+namespace s2
+{
+	static constexpr char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	struct base64table
+	{
+		uint8_t values[256];
+	};
+
+	static constexpr base64table make_base64_table()
+	{
+		base64table ret = {};
+		for (int i = 0; i < 256; i++) {
+			ret.values[i] = 0xFF;
+		}
+		for (int i = 0; i < 64; i++) {
+			ret.values[(uint8_t)base64_chars[i]] = (uint8_t)i;
+		}
+		return ret;
+	}
+
+	static constexpr base64table base64_table = make_base64_table();
+
+	static inline int hex_value(char c)
+	{
+		if (c >= '0' && c <= '9') {
+			return c - '0';
+		} else if (c >= 'a' && c <= 'f') {
+			return c - 'a' + 10;
+		} else if (c >= 'A' && c <= 'F') {
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+
+	// Appends room for len characters to the string, and returns a pointer to it
+	static inline char* encoding_reserve(string& out, size_t len)
+	{
+		out.ensure_memory(out.len() + len + 1);
+		return (char*)out.c_str() + out.len();
+	}
+
+	static inline void encoding_commit(string& out, size_t len)
+	{
+		size_t newLen = out.len() + len;
+		((char*)out.c_str())[newLen] = '\0';
+		out.set_length_unsafe(newLen);
+	}
+
+#if defined(S2_STRING_AVX2)
+	// Base64 with AVX2 as described in "Faster Base64 Encoding and Decoding using AVX2 Instructions" by Wojciech Muła,
+	// Nick Kurz and Daniel Lemire. Each 128-bit lane turns 12 bytes into 16 characters. Returns the amount of bytes that
+	// were encoded, which is always a multiple of 24.
+	S2_TARGET_AVX2 static size_t encode_base64_avx2(char* dst, const uint8_t* src, size_t len)
+	{
+		const __m256i shuffle = _mm256_setr_epi8(
+			1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+			1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+		const __m256i offsets = _mm256_setr_epi8(
+			65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0,
+			65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+
+		// Each lane reads 16 bytes but only uses 12, so stop while there are still 4 bytes left over
+		size_t i = 0;
+		for (; i + 28 <= len; i += 24) {
+			__m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 12));
+			__m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuffle);
+
+			// Move each 6-bit group into its own byte
+			__m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+			__m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+			__m256i indices = _mm256_or_si256(t0, t1);
+
+			// Turn the values into characters by adding an offset for the range they are in
+			__m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+			range = _mm256_sub_epi8(range, _mm256_cmpgt_epi8(indices, _mm256_set1_epi8(25)));
+			__m256i out = _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+
+			_mm256_storeu_si256((__m256i*)(dst + i / 3 * 4), out);
+		}
+		return i;
+	}
+
+	// Decodes blocks of 32 characters into 24 bytes, and stops at the first block that has anything other than the 64
+	// base64 characters in it, including padding. Returns the amount of characters that were decoded.
+	S2_TARGET_AVX2 static size_t decode_base64_avx2(uint8_t* dst, const char* src, size_t len)
+	{
+		const __m256i lutLo = _mm256_setr_epi8(
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+			0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+		const __m256i lutHi = _mm256_setr_epi8(
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+			0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+		const __m256i lutRoll = _mm256_setr_epi8(
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+			0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+		const __m256i mask2F = _mm256_set1_epi8(0x2F);
+		const __m256i pack = _mm256_setr_epi8(
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+			2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			__m256i str = _mm256_loadu_si256((const __m256i*)(src + i));
+
+			// A character is valid when the bits that are looked up from its low and high nibble have nothing in common
+			__m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask2F);
+			__m256i loNibbles = _mm256_and_si256(str, mask2F);
+			__m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+			__m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+			if (!_mm256_testz_si256(lo, hi)) {
+				break;
+			}
+
+			__m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(str, mask2F), hiNibbles));
+			str = _mm256_add_epi8(str, roll);
+
+			// Merge the 6-bit values into 24-bit groups, and pack those together
+			__m256i merged = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+			merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+			merged = _mm256_shuffle_epi8(merged, pack);
+			merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+			uint8_t* out = dst + i / 4 * 3;
+			_mm_storeu_si128((__m128i*)out, _mm256_castsi256_si128(merged));
+			_mm_storel_epi64((__m128i*)(out + 16), _mm256_extracti128_si256(merged, 1));
+		}
+		return i;
+	}
+#endif
+
+#if defined(S2_STRING_SSE2)
+	// Turns 16 bytes into 32 hex characters
+	static size_t encode_hex_sse2(char* dst, const uint8_t* src, size_t len, bool uppercase)
+	{
+		const __m128i mask = _mm_set1_epi8(0x0F);
+		const __m128i nine = _mm_set1_epi8(9);
+		const __m128i zero = _mm_set1_epi8('0');
+		const __m128i letters = _mm_set1_epi8((uppercase ? 'A' : 'a') - '0' - 10);
+
+		size_t i = 0;
+		for (; i + 16 <= len; i += 16) {
+			__m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+			__m128i lo = _mm_and_si128(in, mask);
+
+			hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letters));
+			lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letters));
+
+			_mm_storeu_si128((__m128i*)(dst + i * 2), _mm_unpacklo_epi8(hi, lo));
+			_mm_storeu_si128((__m128i*)(dst + i * 2 + 16), _mm_unpackhi_epi8(hi, lo));
+		}
+		return i;
+	}
+
+	static inline __m128i decode_hex_nibbles_sse2(__m128i c, __m128i& invalid)
+	{
+		// Wrapping subtraction, so that anything below the range becomes large and fails the unsigned comparison
+		__m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+		__m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+		__m128i isDigit = _mm_cmpeq_epi8(_mm_subs_epu8(digit, _mm_set1_epi8(9)), _mm_setzero_si128());
+		__m128i isLetter = _mm_cmpeq_epi8(_mm_subs_epu8(letter, _mm_set1_epi8(5)), _mm_setzero_si128());
+		invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(isDigit, isLetter), _mm_set1_epi8(-1)));
+		return _mm_or_si128(_mm_and_si128(isDigit, digit), _mm_andnot_si128(isDigit, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+	}
+
+	// Turns 32 hex characters into 16 bytes, and stops at the first block with an invalid character
+	static size_t decode_hex_sse2(uint8_t* dst, const char* src, size_t len)
+	{
+		const __m128i lowByte = _mm_set1_epi16(0xFF);
+
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			__m128i invalid = _mm_setzero_si128();
+			__m128i a = decode_hex_nibbles_sse2(_mm_loadu_si128((const __m128i*)(src + i)), invalid);
+			__m128i b = decode_hex_nibbles_sse2(_mm_loadu_si128((const __m128i*)(src + i + 16)), invalid);
+			if (_mm_movemask_epi8(invalid) != 0) {
+				break;
+			}
+
+			// Each 16-bit lane holds the high nibble in its first byte and the low nibble in its second byte
+			a = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(a, lowByte), 4), _mm_srli_epi16(a, 8));
+			b = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b, lowByte), 4), _mm_srli_epi16(b, 8));
+			_mm_storeu_si128((__m128i*)(dst + i / 2), _mm_packus_epi16(a, b));
+		}
+		return i;
+	}
+#endif
+}
+
+size_t s2::encode_base64(char* dst, const void* src, size_t len)
+{
+	const uint8_t* p = (const uint8_t*)src;
+	size_t i = 0;
+
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		i = encode_base64_avx2(dst, p, len);
+	}
+#endif
+
+	char* out = dst + i / 3 * 4;
+	for (; i + 3 <= len; i += 3) {
+		uint32_t v = ((uint32_t)p[i] << 16) | ((uint32_t)p[i + 1] << 8) | p[i + 2];
+		out[0] = base64_chars[(v >> 18) & 63];
+		out[1] = base64_chars[(v >> 12) & 63];
+		out[2] = base64_chars[(v >> 6) & 63];
+		out[3] = base64_chars[v & 63];
+		out += 4;
+	}
+
+	size_t rest = len - i;
+	if (rest > 0) {
+		uint32_t v = (uint32_t)p[i] << 16;
+		if (rest == 2) {
+			v |= (uint32_t)p[i + 1] << 8;
+		}
+		out[0] = base64_chars[(v >> 18) & 63];
+		out[1] = base64_chars[(v >> 12) & 63];
+		out[2] = rest == 2 ? base64_chars[(v >> 6) & 63] : '=';
+		out[3] = '=';
+		out += 4;
+	}
+
+	return out - dst;
+}
+
+size_t s2::encode_hex(char* dst, const void* src, size_t len, bool uppercase)
+{
+	const uint8_t* p = (const uint8_t*)src;
+	const char* digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+	size_t i = 0;
+
+#if defined(S2_STRING_SSE2)
+	i = encode_hex_sse2(dst, p, len, uppercase);
+#endif
+
+	for (; i < len; i++) {
+		dst[i * 2] = digits[p[i] >> 4];
+		dst[i * 2 + 1] = digits[p[i] & 15];
+	}
+	return len * 2;
+}
+
+size_t s2::decode_base64(void* dst, const char* src, size_t len)
+{
+	if (len % 4 != 0) {
+		return encoding_error;
+	}
+
+	uint8_t* out = (uint8_t*)dst;
+	size_t i = 0;
+
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		i = decode_base64_avx2(out, src, len);
+		out += i / 4 * 3;
+	}
+#endif
+
+	const uint8_t* table = base64_table.values;
+	for (; i < len; i += 4) {
+		uint8_t a = table[(uint8_t)src[i]];
+		uint8_t b = table[(uint8_t)src[i + 1]];
+		uint8_t c = table[(uint8_t)src[i + 2]];
+		uint8_t d = table[(uint8_t)src[i + 3]];
+		if ((a | b | c | d) < 64) {
+			uint32_t v = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+			out[0] = (uint8_t)(v >> 16);
+			out[1] = (uint8_t)(v >> 8);
+			out[2] = (uint8_t)v;
+			out += 3;
+			continue;
+		}
+
+		// Only the last group may have padding, which is either "xx==" or "xxx="
+		if (i + 4 != len || a > 63 || b > 63) {
+			return encoding_error;
+		}
+		if (src[i + 2] == '=' && src[i + 3] == '=') {
+			if ((b & 15) != 0) {
+				return encoding_error;
+			}
+			*out++ = (uint8_t)((a << 2) | (b >> 4));
+		} else if (c < 64 && src[i + 3] == '=') {
+			if ((c & 3) != 0) {
+				return encoding_error;
+			}
+			*out++ = (uint8_t)((a << 2) | (b >> 4));
+			*out++ = (uint8_t)((b << 4) | (c >> 2));
+		} else {
+			return encoding_error;
+		}
+	}
+
+	return out - (uint8_t*)dst;
+}
+
+size_t s2::decode_hex(void* dst, const char* src, size_t len)
+{
+	if (len % 2 != 0) {
+		return encoding_error;
+	}
+
+	uint8_t* out = (uint8_t*)dst;
+	size_t i = 0;
+
+#if defined(S2_STRING_SSE2)
+	i = decode_hex_sse2(out, src, len);
+#endif
+
+	for (; i < len; i += 2) {
+		int hi = hex_value(src[i]);
+		int lo = hex_value(src[i + 1]);
+		if (hi < 0 || lo < 0) {
+			return encoding_error;
+		}
+		out[i / 2] = (uint8_t)((hi << 4) | lo);
+	}
+	return len / 2;
+}
+
+void s2::encode_base64(s2::string& out, const void* src, size_t len)
+{
+	char* p = encoding_reserve(out, base64_encoded_length(len));
+	encoding_commit(out, encode_base64(p, src, len));
+}
+
+void s2::encode_hex(s2::string& out, const void* src, size_t len, bool uppercase)
+{
+	char* p = encoding_reserve(out, hex_encoded_length(len));
+	encoding_commit(out, encode_hex(p, src, len, uppercase));
+}
+
+bool s2::decode_base64(s2::string& out, const s2::stringview& src)
+{
+	char* p = encoding_reserve(out, base64_decoded_length(src.len()));
+	size_t len = decode_base64(p, src.c_str(), src.len());
+	if (len == encoding_error) {
+		encoding_commit(out, 0);
+		return false;
+	}
+	encoding_commit(out, len);
+	return true;
+}
+
+bool s2::decode_hex(s2::string& out, const s2::stringview& src)
+{
+	char* p = encoding_reserve(out, hex_decoded_length(src.len()));
+	size_t len = decode_hex(p, src.c_str(), src.len());
+	if (len == encoding_error) {
+		encoding_commit(out, 0);
+		return false;
+	}
+	encoding_commit(out, len);
+	return true;
+}
+#endif
@@ -3,8 +3,19 @@
 #define S2_USING_FILE
 
 #include <cstddef>
+#include <cstdlib>
 #include <cstring>
 
+#ifndef S2_MALLOC
+#define S2_MALLOC(size) ::malloc(size)
+#endif
+#ifndef S2_REALLOC
+#define S2_REALLOC(ptr, size) ::realloc(ptr, size)
+#endif
+#ifndef S2_FREE
+#define S2_FREE(ptr) ::free(ptr)
+#endif
+
 namespace s2
 {
 	class fileexception
@@ -149,10 +160,10 @@ public:
 	ToWide(const char* src)
 	{
 		int size = MultiByteToWideChar(CP_UTF8, 0, src, -1, 0, 0);
-		m_buffer = (wchar_t*)malloc(size * sizeof(wchar_t));
+		m_buffer = (wchar_t*)S2_MALLOC(size * sizeof(wchar_t));
 		MultiByteToWideChar(CP_UTF8, 0, src, -1, m_buffer, size);
 	}
-	~ToWide() { free(m_buffer); }
+	~ToWide() { S2_FREE(m_buffer); }
 	operator const wchar_t* () { return m_buffer; }
 	wchar_t* buffer() { return m_buffer; }
 };
@@ -166,10 +177,10 @@ public:
 	ToUtf8(const wchar_t* src)
 	{
 		int size = WideCharToMultiByte(CP_UTF8, 0, src, -1, 0, 0, 0, 0);
-		m_buffer = (char*)malloc(size * sizeof(char));
+		m_buffer = (char*)S2_MALLOC(size * sizeof(char));
 		WideCharToMultiByte(CP_UTF8, 0, src, -1, m_buffer, size, 0, 0);
 	}
-	~ToUtf8() { free(m_buffer); }
+	~ToUtf8() { S2_FREE(m_buffer); }
 	operator const char* () { return m_buffer; }
 	char* buffer() { return m_buffer; }
 };
@@ -186,31 +197,31 @@ s2::file::file()
 s2::file::file(const char* filename)
 	: file()
 {
-	m_filename = (char*)malloc(strlen(filename) + 1);
+	m_filename = (char*)S2_MALLOC(strlen(filename) + 1);
 	strcpy(m_filename, filename);
 }
 
 s2::file::~file()
 {
 	if (m_filename != nullptr) {
-		free(m_filename);
+		S2_FREE(m_filename);
 	}
 	if (m_fh != nullptr) {
 		fclose((FILE*)m_fh);
 	}
 
 	if (m_readData != nullptr) {
-		free(m_readData);
+		S2_FREE(m_readData);
 	}
 }
 
 void s2::file::open(const char* filename, s2::filemode mode)
 {
 	if (m_filename != nullptr) {
-		free(m_filename);
+		S2_FREE(m_filename);
 	}
 
-	m_filename = (char*)malloc(strlen(filename) + 1);
+	m_filename = (char*)S2_MALLOC(strlen(filename) + 1);
 	strcpy(m_filename, filename);
 
 	open(mode);
@@ -349,7 +360,7 @@ const char* s2::file::readline()
 	}
 
 	if (m_readData == nullptr) {
-		m_readData = (char*)malloc(S2_FILE_READLINE_BUFFERSIZE + 1);
+		m_readData = (char*)S2_MALLOC(S2_FILE_READLINE_BUFFERSIZE + 1);
 	}
 
 	if (fgets(m_readData, S2_FILE_READLINE_BUFFERSIZE, (FILE*)m_fh) == nullptr) {
@@ -380,11 +391,11 @@ const char* s2::file::readtoend(size_t* out_size)
 	}
 
 	if (m_readData != nullptr) {
-		free(m_readData);
+		S2_FREE(m_readData);
 	}
 
 	size_t readsize = size() - pos();
-	m_readData = (char*)malloc(readsize + 1);
+	m_readData = (char*)S2_MALLOC(readsize + 1);
 	m_readData[readsize] = '\0';
 
 	read(m_readData, readsize);
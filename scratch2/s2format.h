@@ -0,0 +1,253 @@
+#pragma once
+
+#define S2_USING_FORMAT
+
+#include "s2string.h"
+
+// Wraps a string literal into a type that s2::format can parse at compile time, for example:
+//   s2::format(S2_FMT("{} is {} years old"), name, age)
+#define S2_FMT(str) [] { struct formatstring { static constexpr const char* value() { return str; } }; return formatstring(); }()
+
+namespace s2
+{
+	// A piece of a parsed format string: either a run of literal text, or a placeholder for an argument.
+	struct formatpiece
+	{
+		size_t start = 0;
+		size_t len = 0;
+		int arg = -1;
+	};
+
+	// Parses a format string where "{}" is a placeholder for the next argument, and "{{" and "}}" are literal braces.
+	// Everything in here is constexpr, so that the format string is only ever parsed by the compiler.
+	class formatparser
+	{
+	public:
+		// Calls the given function for each piece of the format string, and returns false if the format is invalid.
+		template<typename TFunc>
+		static constexpr bool parse(const char* str, TFunc&& func)
+		{
+			size_t start = 0;
+			size_t i = 0;
+			int arg = 0;
+			while (str[i] != '\0') {
+				char c = str[i];
+				if (c != '{' && c != '}') {
+					i++;
+					continue;
+				}
+
+				if (i > start) {
+					func(formatpiece{ start, i - start, -1 });
+				}
+
+				if (str[i + 1] == c) {
+					// An escaped brace: keep the first one as literal text
+					func(formatpiece{ i, 1, -1 });
+					i += 2;
+				} else if (c == '{' && str[i + 1] == '}') {
+					func(formatpiece{ i, 0, arg++ });
+					i += 2;
+				} else {
+					return false;
+				}
+				start = i;
+			}
+
+			if (i > start) {
+				func(formatpiece{ start, i - start, -1 });
+			}
+			return true;
+		}
+
+		static constexpr bool is_valid(const char* str)
+		{
+			return parse(str, [](const formatpiece&) {});
+		}
+
+		static constexpr size_t count_pieces(const char* str)
+		{
+			size_t ret = 0;
+			parse(str, [&ret](const formatpiece&) { ret++; });
+			return ret;
+		}
+
+		static constexpr int count_args(const char* str)
+		{
+			int ret = 0;
+			parse(str, [&ret](const formatpiece& piece) {
+				if (piece.arg >= 0) {
+					ret++;
+				}
+			});
+			return ret;
+		}
+	};
+
+	template<size_t N>
+	struct formatpieces
+	{
+		formatpiece items[N > 0 ? N : 1];
+	};
+
+	// The compile-time parsed form of the format string given by TFormat.
+	template<typename TFormat>
+	struct formatpattern
+	{
+		static constexpr const char* str = TFormat::value();
+		static constexpr bool valid = formatparser::is_valid(str);
+		static constexpr size_t num_pieces = formatparser::count_pieces(str);
+		static constexpr int num_args = formatparser::count_args(str);
+
+		static constexpr formatpieces<num_pieces> make_pieces()
+		{
+			formatpieces<num_pieces> ret;
+			size_t index = 0;
+			formatparser::parse(str, [&ret, &index](const formatpiece& piece) { ret.items[index++] = piece; });
+			return ret;
+		}
+
+		static constexpr formatpieces<num_pieces> pieces = make_pieces();
+	};
+
+	// Formats into an s2::string, writing numbers straight into its buffer.
+	class formatstringsink
+	{
+	private:
+		string& m_str;
+
+	public:
+		inline formatstringsink(string& str) : m_str(str) {}
+
+		inline void write(const char* sz, size_t len) { m_str.append(sz, len); }
+		inline void write_int(int64_t value) { m_str.append_int(value); }
+		inline void write_uint(uint64_t value) { m_str.append_uint(value); }
+		inline void write_double(double value) { m_str.append_double(value); }
+		inline void write_float(float value) { m_str.append_float(value); }
+	};
+
+	// Formats into anything with a `write(buffer, size)` function, such as s2::file.
+	template<typename TWriter>
+	class formatwritersink
+	{
+	private:
+		TWriter& m_writer;
+
+	public:
+		inline formatwritersink(TWriter& writer) : m_writer(writer) {}
+
+		inline void write(const char* sz, size_t len) { m_writer.write(sz, len); }
+
+		inline void write_int(int64_t value)
+		{
+			char buffer[max_number_length];
+			write(buffer, format_int(buffer, value));
+		}
+
+		inline void write_uint(uint64_t value)
+		{
+			char buffer[max_number_length];
+			write(buffer, format_uint(buffer, value));
+		}
+
+		inline void write_double(double value)
+		{
+			char buffer[max_number_length];
+			write(buffer, format_double(buffer, value));
+		}
+
+		inline void write_float(float value)
+		{
+			char buffer[max_number_length];
+			write(buffer, format_float(buffer, value));
+		}
+	};
+
+	// Writers for each type of argument. Types without a writer are rejected at compile time, instead of being
+	// converted to something unexpected, like a pointer to a bool.
+	template<typename TSink, typename T> void format_value(TSink& sink, const T& value) = delete;
+
+	template<typename TSink> inline void format_value(TSink& sink, const char* value)
+	{
+		if (value == nullptr) {
+			sink.write("(null)", 6);
+		} else {
+			sink.write(value, strlen(value));
+		}
+	}
+	template<typename TSink> inline void format_value(TSink& sink, char* value) { format_value(sink, (const char*)value); }
+	template<typename TSink> inline void format_value(TSink& sink, const string& value) { sink.write(value.c_str(), value.len()); }
+	template<typename TSink> inline void format_value(TSink& sink, const stringview& value) { sink.write(value.c_str(), value.len()); }
+	template<typename TSink> inline void format_value(TSink& sink, char value) { sink.write(&value, 1); }
+	template<typename TSink> inline void format_value(TSink& sink, bool value) { value ? sink.write("true", 4) : sink.write("false", 5); }
+	template<typename TSink> inline void format_value(TSink& sink, signed char value) { sink.write_int(value); }
+	template<typename TSink> inline void format_value(TSink& sink, short value) { sink.write_int(value); }
+	template<typename TSink> inline void format_value(TSink& sink, int value) { sink.write_int(value); }
+	template<typename TSink> inline void format_value(TSink& sink, long value) { sink.write_int(value); }
+	template<typename TSink> inline void format_value(TSink& sink, long long value) { sink.write_int(value); }
+	template<typename TSink> inline void format_value(TSink& sink, unsigned char value) { sink.write_uint(value); }
+	template<typename TSink> inline void format_value(TSink& sink, unsigned short value) { sink.write_uint(value); }
+	template<typename TSink> inline void format_value(TSink& sink, unsigned int value) { sink.write_uint(value); }
+	template<typename TSink> inline void format_value(TSink& sink, unsigned long value) { sink.write_uint(value); }
+	template<typename TSink> inline void format_value(TSink& sink, unsigned long long value) { sink.write_uint(value); }
+	template<typename TSink> inline void format_value(TSink& sink, float value) { sink.write_float(value); }
+	template<typename TSink> inline void format_value(TSink& sink, double value) { sink.write_double(value); }
+
+	template<int N, typename TFirst, typename... TRest>
+	inline const auto& format_get_arg(const TFirst& first, const TRest&... rest)
+	{
+		if constexpr (N == 0) {
+			return first;
+		} else {
+			return format_get_arg<N - 1>(rest...);
+		}
+	}
+
+	template<typename TPattern, size_t I, typename TSink, typename... TArgs>
+	inline void format_pieces(TSink& sink, const TArgs&... args)
+	{
+		if constexpr (I < TPattern::num_pieces) {
+			constexpr formatpiece piece = TPattern::pieces.items[I];
+			if constexpr (piece.arg < 0) {
+				sink.write(TPattern::str + piece.start, piece.len);
+			} else {
+				format_value(sink, format_get_arg<piece.arg>(args...));
+			}
+			format_pieces<TPattern, I + 1>(sink, args...);
+		}
+	}
+
+	template<typename TFormat, typename TSink, typename... TArgs>
+	inline void format_into(TSink& sink, const TArgs&... args)
+	{
+		typedef formatpattern<TFormat> pattern;
+		static_assert(pattern::valid, "Invalid format string: braces must be \"{}\", \"{{\" or \"}}\"");
+		static_assert(pattern::num_args == (int)sizeof...(TArgs), "The number of arguments does not match the format string");
+		format_pieces<pattern, 0>(sink, args...);
+	}
+
+	// Appends the formatted text to the given string.
+	template<typename TFormat, typename... TArgs>
+	inline void format_to(string& out, TFormat, const TArgs&... args)
+	{
+		formatstringsink sink(out);
+		format_into<TFormat>(sink, args...);
+	}
+
+	// Writes the formatted text to the given writer by calling `writer.write(buffer, size)`, for example an s2::file.
+	template<typename TWriter, typename TFormat, typename... TArgs>
+	inline void format_to(TWriter& writer, TFormat, const TArgs&... args)
+	{
+		formatwritersink<TWriter> sink(writer);
+		format_into<TFormat>(sink, args...);
+	}
+
+	// Returns the formatted text as a new string.
+	template<typename TFormat, typename... TArgs>
+	inline string format(TFormat fmt, const TArgs&... args)
+	{
+		string ret;
+		format_to(ret, fmt, args...);
+		return ret;
+	}
+}
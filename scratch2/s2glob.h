@@ -0,0 +1,370 @@
+#pragma once
+
+#define S2_USING_GLOB
+
+#include "s2string.h"
+
+namespace s2
+{
+	// A wildcard pattern that is compiled once, and can then be matched against any amount of paths. Both '/' and '\'
+	// are path separators, in the pattern as well as in the text, like s2::path::equals. The pattern syntax is:
+	// - `?` matches any single character except a separator
+	// - `*` matches any amount of characters except separators
+	// - `**` as a whole path component matches any amount of directories, for example `logs/**/*.gz` matches both
+	//   `logs/a.gz` and `logs/2024/01/a.gz`, and a trailing `logs/**` matches everything inside `logs`
+	// - `[abc]`, `[a-z]` match one of the characters, and `[!abc]` or `[^abc]` match any other character except a
+	//   separator. An unterminated `[` is matched literally.
+	// There is no escape character, since a backslash is a separator.
+	class glob
+	{
+	private:
+		string m_pattern;
+		bool m_caseSensitive;
+
+		// The pattern is simulated as an NFA with one bit per state, where state i means that the first i tokens matched.
+		// For each byte there is a mask of states that it moves forward, and a mask of states that loop on it. A "**/" in
+		// the middle of the pattern takes two states: one that can skip the whole token, and one inside it.
+		size_t m_numTokens = 0;
+		size_t m_numWords = 0;
+		uint64_t* m_masks = nullptr;
+		uint64_t* m_epsilon = nullptr;
+		uint64_t* m_skip = nullptr;
+
+		// The literal text at the start and end of the pattern, with separators as '/', which is checked before the NFA
+		string m_prefix;
+		string m_suffix;
+		bool m_literal = true;
+
+	public:
+		glob(const stringview& pattern, bool caseSensitive = true);
+		glob(const glob& copy);
+		~glob();
+
+		glob& operator =(const glob& copy);
+
+		inline const string& pattern() const { return m_pattern; }
+
+		// Returns true if the entire text matches the pattern.
+		bool matches(const stringview& text) const;
+
+		// Compiles the pattern and matches it once. Use a glob object instead when matching the same pattern many times.
+		static bool match(const stringview& pattern, const stringview& text, bool caseSensitive = true);
+
+	private:
+		void compile();
+		void release();
+
+		inline uint64_t* forward_mask(uint8_t c) const { return m_masks + (size_t)c * m_numWords * 2; }
+		inline uint64_t* self_mask(uint8_t c) const { return m_masks + (size_t)c * m_numWords * 2 + m_numWords; }
+
+		void closure(uint64_t* states) const;
+		char normalize(char c) const;
+	};
+}
+
+#if defined(S2_IMPL)
+namespace s2
+{
+	static inline bool glob_is_separator(char c)
+	{
+		return c == '/' || c == '\\';
+	}
+
+	static inline char glob_swap_case(char c)
+	{
+		if (c >= 'a' && c <= 'z') {
+			return c - ('a' - 'A');
+		} else if (c >= 'A' && c <= 'Z') {
+			return c + ('a' - 'A');
+		}
+		return c;
+	}
+
+	static inline void glob_set_bit(uint64_t* words, size_t bit)
+	{
+		words[bit / 64] |= 1ull << (bit % 64);
+	}
+}
+
+s2::glob::glob(const s2::stringview& pattern, bool caseSensitive)
+	: m_pattern(pattern.c_str(), pattern.len()), m_caseSensitive(caseSensitive)
+{
+	compile();
+}
+
+s2::glob::glob(const s2::glob& copy)
+	: m_pattern(copy.m_pattern), m_caseSensitive(copy.m_caseSensitive)
+{
+	compile();
+}
+
+s2::glob::~glob()
+{
+	release();
+}
+
+s2::glob& s2::glob::operator =(const s2::glob& copy)
+{
+	if (this != &copy) {
+		release();
+		m_pattern = copy.m_pattern;
+		m_caseSensitive = copy.m_caseSensitive;
+		compile();
+	}
+	return *this;
+}
+
+bool s2::glob::matches(const s2::stringview& text) const
+{
+	const char* p = text.c_str();
+	size_t len = text.len();
+
+	// Most patterns start with a directory or end with an extension, so check those before running the NFA
+	size_t prefixLen = m_prefix.len();
+	size_t suffixLen = m_suffix.len();
+	if (m_literal) {
+		if (len != prefixLen) {
+			return false;
+		}
+	} else if (len < prefixLen + suffixLen) {
+		return false;
+	}
+
+	for (size_t i = 0; i < prefixLen; i++) {
+		if (normalize(p[i]) != m_prefix.c_str()[i]) {
+			return false;
+		}
+	}
+	if (m_literal) {
+		return true;
+	}
+	for (size_t i = 0; i < suffixLen; i++) {
+		if (normalize(p[len - suffixLen + i]) != m_suffix.c_str()[i]) {
+			return false;
+		}
+	}
+
+	// Patterns up to 512 tokens keep the states on the stack
+	uint64_t local[16];
+	uint64_t* states = m_numWords <= 8 ? local : (uint64_t*)S2_MALLOC(m_numWords * 2 * sizeof(uint64_t));
+	uint64_t* next = states + m_numWords;
+
+	memset(states, 0, m_numWords * sizeof(uint64_t));
+	glob_set_bit(states, prefixLen);
+	closure(states);
+
+	bool alive = true;
+	for (size_t i = prefixLen; i < len && alive; i++) {
+		const uint64_t* fwd = forward_mask((uint8_t)p[i]);
+		const uint64_t* self = self_mask((uint8_t)p[i]);
+
+		uint64_t any = 0;
+		uint64_t carry = 0;
+		for (size_t w = 0; w < m_numWords; w++) {
+			uint64_t cur = states[w];
+			next[w] = (((cur << 1) | carry) & fwd[w]) | (cur & self[w]);
+			carry = cur >> 63;
+			any |= next[w];
+		}
+		closure(next);
+
+		uint64_t* tmp = states;
+		states = next;
+		next = tmp;
+		alive = any != 0;
+	}
+
+	bool ret = alive && ((states[m_numTokens / 64] >> (m_numTokens % 64)) & 1);
+
+	if (m_numWords > 8) {
+		// The two halves may have been swapped, so free whichever one starts the allocation
+		S2_FREE(states < next ? states : next);
+	}
+	return ret;
+}
+
+bool s2::glob::match(const s2::stringview& pattern, const s2::stringview& text, bool caseSensitive)
+{
+	return glob(pattern, caseSensitive).matches(text);
+}
+
+void s2::glob::compile()
+{
+	const char* p = m_pattern.c_str();
+	size_t len = m_pattern.len();
+
+	// Every token uses at least one character of the pattern, so this is enough room for all states
+	m_numWords = len / 64 + 1;
+	m_masks = (uint64_t*)S2_MALLOC(256 * 2 * m_numWords * sizeof(uint64_t));
+	m_epsilon = (uint64_t*)S2_MALLOC(2 * m_numWords * sizeof(uint64_t));
+	m_skip = m_epsilon + m_numWords;
+	memset(m_masks, 0, 256 * 2 * m_numWords * sizeof(uint64_t));
+	memset(m_epsilon, 0, 2 * m_numWords * sizeof(uint64_t));
+
+	m_numTokens = 0;
+	m_prefix = "";
+	m_suffix = "";
+	m_literal = true;
+
+	size_t i = 0;
+	while (i < len) {
+		size_t t = m_numTokens++;
+		char c = p[i];
+
+		if (c == '*') {
+			size_t end = i;
+			while (end < len && p[end] == '*') {
+				end++;
+			}
+
+			bool wholeComponent = end - i > 1 && (i == 0 || glob_is_separator(p[i - 1])) && (end == len || glob_is_separator(p[end]));
+			if (wholeComponent && end < len) {
+				// A "**/" in the middle either matches nothing, or it is entered and can then only be left on a
+				// separator, so that it always covers whole directories
+				m_numTokens++;
+				glob_set_bit(m_skip, t);
+				glob_set_bit(m_epsilon, t);
+				for (int b = 0; b < 256; b++) {
+					glob_set_bit(self_mask((uint8_t)b), t + 1);
+				}
+				glob_set_bit(forward_mask('/'), t + 2);
+				glob_set_bit(forward_mask('\\'), t + 2);
+				end++;
+			} else {
+				for (int b = 0; b < 256; b++) {
+					if (wholeComponent || !glob_is_separator((char)b)) {
+						glob_set_bit(self_mask((uint8_t)b), t);
+					}
+				}
+				glob_set_bit(m_epsilon, t);
+			}
+
+			m_literal = false;
+			m_suffix = "";
+			i = end;
+			continue;
+		}
+
+		if (c == '[') {
+			size_t end = i + 1;
+			bool negate = end < len && (p[end] == '!' || p[end] == '^');
+			if (negate) {
+				end++;
+			}
+
+			// A ']' right at the start is part of the set
+			size_t first = end;
+			if (end < len && p[end] == ']') {
+				end++;
+			}
+			while (end < len && p[end] != ']') {
+				end++;
+			}
+
+			if (end < len) {
+				charset set;
+				for (size_t j = first; j < end; j++) {
+					if (j + 2 < end && p[j + 1] == '-') {
+						for (int r = (uint8_t)p[j]; r <= (uint8_t)p[j + 2]; r++) {
+							set.add((char)r);
+						}
+						j += 2;
+					} else {
+						set.add(p[j]);
+					}
+				}
+
+				for (int b = 0; b < 256; b++) {
+					char bc = (char)b;
+					if (glob_is_separator(bc)) {
+						continue;
+					}
+					bool contains = set.contains(bc);
+					if (!m_caseSensitive && !contains) {
+						contains = set.contains(glob_swap_case(bc));
+					}
+					if (contains != negate) {
+						glob_set_bit(forward_mask((uint8_t)b), t + 1);
+					}
+				}
+
+				m_literal = false;
+				m_suffix = "";
+				i = end + 1;
+				continue;
+			}
+		}
+
+		if (c == '?') {
+			for (int b = 0; b < 256; b++) {
+				if (!glob_is_separator((char)b)) {
+					glob_set_bit(forward_mask((uint8_t)b), t + 1);
+				}
+			}
+			m_literal = false;
+			m_suffix = "";
+			i++;
+			continue;
+		}
+
+		// A literal character, or a separator which matches both kinds
+		char n = normalize(c);
+		for (int b = 0; b < 256; b++) {
+			if (normalize((char)b) == n) {
+				glob_set_bit(forward_mask((uint8_t)b), t + 1);
+			}
+		}
+		if (m_literal) {
+			m_prefix.append(n);
+		} else {
+			m_suffix.append(n);
+		}
+		i++;
+	}
+}
+
+void s2::glob::release()
+{
+	if (m_masks != nullptr) {
+		S2_FREE(m_masks);
+		S2_FREE(m_epsilon);
+		m_masks = nullptr;
+		m_epsilon = nullptr;
+		m_skip = nullptr;
+	}
+}
+
+void s2::glob::closure(uint64_t* states) const
+{
+	// Wildcards that can match nothing also activate the state after them, or the state after both states of a "**/".
+	// This repeats for runs of such wildcards, like in "**/*", which are always short.
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		uint64_t carry = 0;
+		uint64_t skipCarry = 0;
+		for (size_t w = 0; w < m_numWords; w++) {
+			uint64_t epsilon = states[w] & m_epsilon[w];
+			uint64_t skip = states[w] & m_skip[w];
+			uint64_t add = (epsilon << 1) | carry | (skip << 2) | skipCarry;
+			carry = epsilon >> 63;
+			skipCarry = skip >> 62;
+			if ((add & ~states[w]) != 0) {
+				states[w] |= add;
+				changed = true;
+			}
+		}
+	}
+}
+
+char s2::glob::normalize(char c) const
+{
+	if (c == '\\') {
+		return '/';
+	}
+	if (!m_caseSensitive && c >= 'A' && c <= 'Z') {
+		return c + ('a' - 'A');
+	}
+	return c;
+}
+#endif
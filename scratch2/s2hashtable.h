@@ -2,10 +2,105 @@
 
 #define S2_USING_HASHTABLE
 
+#include <cstdlib>
 #include <cstring>
 #include <cstdint>
 #include <new>
 
+#ifndef S2_MALLOC
+#define S2_MALLOC(size) ::malloc(size)
+#endif
+#ifndef S2_REALLOC
+#define S2_REALLOC(ptr, size) ::realloc(ptr, size)
+#endif
+#ifndef S2_FREE
+#define S2_FREE(ptr) ::free(ptr)
+#endif
+
+#ifndef S2_USING_DEFAULT_ALLOCATOR
+#define S2_USING_DEFAULT_ALLOCATOR
+namespace s2
+{
+	// Allocates memory through S2_MALLOC, S2_REALLOC, and S2_FREE. Containers take a class with these same static
+	// functions as a template parameter, which can be used to give specific containers their own memory.
+	class default_allocator
+	{
+	public:
+		static inline void* allocate(size_t size) { return S2_MALLOC(size); }
+		static inline void* reallocate(void* ptr, size_t size) { return S2_REALLOC(ptr, size); }
+		static inline void deallocate(void* ptr) { S2_FREE(ptr); }
+	};
+}
+#endif
+
+#ifndef S2_USING_CONSTEXPR_HASH
+#define S2_USING_CONSTEXPR_HASH
+namespace s2
+{
+	// A modified MurmurHash64A by Austin Appleby, which the default hashers use for null-terminated strings. It can also
+	// be evaluated at compile time.
+	constexpr uint64_t hash_string(const char* str, size_t size)
+	{
+		const uint64_t seed = 0x2f97bc371e161991llu;
+		const uint64_t m = 0xc6a4a7935bd1e995llu;
+		const int r = 47;
+
+		int len = (int)size;
+
+		uint64_t h = seed ^ (len * m);
+
+		int blocks = len / 8;
+		for (int i = 0; i < blocks; i++) {
+			uint64_t k = 0;
+			for (int j = 7; j >= 0; j--) {
+				k = (k << 8) | (uint8_t)str[i * 8 + j];
+			}
+
+			k *= m;
+			k ^= k >> r;
+			k *= m;
+
+			h ^= k;
+			h *= m;
+		}
+
+		int rest = len & 7;
+		if (rest > 0) {
+			const char* tail = str + blocks * 8;
+			for (int j = rest - 1; j >= 0; j--) {
+				h ^= uint64_t((uint8_t)tail[j]) << (j * 8);
+			}
+			h *= m;
+		}
+
+		h ^= h >> r;
+		h *= m;
+		h ^= h >> r;
+
+		return h;
+	}
+
+	constexpr uint64_t hash_string(const char* str)
+	{
+		size_t len = 0;
+		while (str[len] != '\0') {
+			len++;
+		}
+		return hash_string(str, len);
+	}
+
+	inline namespace literals
+	{
+		// Hashes a string literal at compile time, for example: table.get_prehashed("key"_s2h, value). It can be used
+		// after `using namespace s2::literals;`.
+		constexpr uint64_t operator""_s2h(const char* str, size_t len)
+		{
+			return hash_string(str, len);
+		}
+	}
+}
+#endif
+
 namespace s2
 {
 	enum class hashtableexception
@@ -86,13 +181,13 @@ namespace s2
 		}
 	};
 
-	template<typename TKey, typename TValue, typename THasher = default_hashers_hashtable>
+	template<typename TKey, typename TValue, typename THasher = default_hashers_hashtable, typename TAllocator = default_allocator>
 	class hashtable
 	{
 	public:
 		typedef hashtable_entry<TKey, TValue, THasher> entry;
-		typedef hashtable_iterator<hashtable<TKey, TValue, THasher>, entry> iterator;
-		typedef hashtable_iterator<const hashtable<TKey, TValue, THasher>, const entry> constiterator;
+		typedef hashtable_iterator<hashtable<TKey, TValue, THasher, TAllocator>, entry> iterator;
+		typedef hashtable_iterator<const hashtable<TKey, TValue, THasher, TAllocator>, const entry> constiterator;
 
 		friend class iterator;
 		friend class constiterator;
@@ -116,7 +211,7 @@ namespace s2
 		{
 			clear();
 			if (m_entries != nullptr) {
-				free(m_entries);
+				TAllocator::deallocate(m_entries);
 			}
 		}
 
@@ -124,7 +219,7 @@ namespace s2
 		{
 			clear();
 			if (m_entries != nullptr) {
-				free(m_entries);
+				TAllocator::deallocate(m_entries);
 				m_entries = nullptr;
 				m_allocSize = 0;
 			}
@@ -285,6 +380,23 @@ namespace s2
 			return true;
 		}
 
+		bool contains_prehashed(uint64_t keyhash) const
+		{
+			return index_of_prehashed(keyhash) != -1;
+		}
+
+		// Same as get(), but skips hashing the key. Since entries are identified by their hash, the key itself isn't needed.
+		bool get_prehashed(uint64_t keyhash, TValue& value) const
+		{
+			int index = index_of_prehashed(keyhash);
+			if (index == -1) {
+				return false;
+			}
+
+			value = m_entries[index].value();
+			return true;
+		}
+
 		entry& at(size_t index)
 		{
 			if (index >= m_length) {
@@ -366,12 +478,22 @@ namespace s2
 				count = resize;
 			}
 
-			m_entries = (entry*)realloc(m_entries, count * sizeof(entry));
+			m_entries = (entry*)TAllocator::reallocate(m_entries, count * sizeof(entry));
 			m_allocSize = count;
 		}
 
 		template<typename TComparable = TKey>
 		int index_of(const TComparable& key) const
+		{
+			if (m_length == 0) {
+				return -1;
+			}
+			return index_of_prehashed(THasher::hash(key));
+		}
+
+		// Finds the index of a key from a hash that was already computed, for example with "key"_s2h. The hash must be
+		// the one THasher would give for the key.
+		int index_of_prehashed(uint64_t keyhash) const
 		{
 			if (m_length == 0) {
 				return -1;
@@ -380,8 +502,6 @@ namespace s2
 			size_t start = 0;
 			size_t end = m_length;
 
-			uint64_t keyhash = THasher::hash(key);
-
 			while (true) {
 				size_t halfLen = end - start;
 				size_t halfIndex = start + halfLen / 2;
@@ -410,48 +530,7 @@ namespace s2
 
 uint64_t s2::default_hashers_hashtable::hash(const char* key)
 {
-	// This is a modified MurmurHash64A by Austin Appleby
-
-	const uint64_t seed = 0x2f97bc371e161991llu;
-	const uint64_t m = 0xc6a4a7935bd1e995llu;
-	const int r = 47;
-
-	int len = (int)strlen(key);
-
-	uint64_t h = seed ^ (len * m);
-
-	const uint64_t* data = (const uint64_t*)key;
-	const uint64_t* end = data + (len / 8);
-
-	while (data != end) {
-		uint64_t k = *data++;
-
-		k *= m;
-		k ^= k >> r;
-		k *= m;
-
-		h ^= k;
-		h *= m;
-	}
-
-	const unsigned char* data2 = (const unsigned char*)data;
-
-	switch (len & 7) {
-	case 7: h ^= uint64_t(data2[6]) << 48;
-	case 6: h ^= uint64_t(data2[5]) << 40;
-	case 5: h ^= uint64_t(data2[4]) << 32;
-	case 4: h ^= uint64_t(data2[3]) << 24;
-	case 3: h ^= uint64_t(data2[2]) << 16;
-	case 2: h ^= uint64_t(data2[1]) << 8;
-	case 1: h ^= uint64_t(data2[0]);
-		h *= m;
-	}
-
-	h ^= h >> r;
-	h *= m;
-	h ^= h >> r;
-
-	return h;
+	return hash_string(key, strlen(key));
 }
 
 uint64_t s2::default_hashers_hashtable::hash(int8_t key) { return (uint64_t)key; }
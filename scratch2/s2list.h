@@ -7,9 +7,35 @@
 #include <new>
 #include <initializer_list>
 
+#ifndef S2_MALLOC
+#define S2_MALLOC(size) ::malloc(size)
+#endif
+#ifndef S2_REALLOC
+#define S2_REALLOC(ptr, size) ::realloc(ptr, size)
+#endif
+#ifndef S2_FREE
+#define S2_FREE(ptr) ::free(ptr)
+#endif
+
+#ifndef S2_USING_DEFAULT_ALLOCATOR
+#define S2_USING_DEFAULT_ALLOCATOR
 namespace s2
 {
-	template<typename T>
+	// Allocates memory through S2_MALLOC, S2_REALLOC, and S2_FREE. Containers take a class with these same static
+	// functions as a template parameter, which can be used to give specific containers their own memory.
+	class default_allocator
+	{
+	public:
+		static inline void* allocate(size_t size) { return S2_MALLOC(size); }
+		static inline void* reallocate(void* ptr, size_t size) { return S2_REALLOC(ptr, size); }
+		static inline void deallocate(void* ptr) { S2_FREE(ptr); }
+	};
+}
+#endif
+
+namespace s2
+{
+	template<typename T, typename TAllocator>
 	class list;
 
 	template<typename LT, typename T>
@@ -48,12 +74,12 @@ namespace s2
 		}
 	};
 
-	template<typename T>
+	template<typename T, typename TAllocator = default_allocator>
 	class list
 	{
 	public:
-		typedef listiterator<list<T>, T> iterator;
-		typedef listiterator<const list<T>, const T> constiterator;
+		typedef listiterator<list<T, TAllocator>, T> iterator;
+		typedef listiterator<const list<T, TAllocator>, const T> constiterator;
 
 	private:
 		T* m_buffer;
@@ -136,7 +162,7 @@ namespace s2
 		void add(T&& o)
 		{
 			ensure_memory(m_length + 1);
-			new (m_buffer + m_length) T(o);
+			new (m_buffer + m_length) T(static_cast<T&&>(o));
 			m_length++;
 		}
 
@@ -249,6 +275,21 @@ namespace s2
 			qsort(m_buffer, m_length, sizeof(T), f);
 		}
 
+		// Sorts using the < operator of the elements.
+		void sort()
+		{
+			qsort(m_buffer, m_length, sizeof(T), [](const void* pa, const void* pb) {
+				auto& a = *(const T*)pa;
+				auto& b = *(const T*)pb;
+				if (a < b) {
+					return -1;
+				} else if (b < a) {
+					return 1;
+				}
+				return 0;
+			});
+		}
+
 		inline const T* data() { return m_buffer; }
 
 		T &operator [](size_t index)
@@ -292,7 +333,7 @@ namespace s2
 				count = resize;
 			}
 
-			m_buffer = (T*)realloc(m_buffer, count * sizeof(T));
+			m_buffer = (T*)TAllocator::reallocate(m_buffer, count * sizeof(T));
 			m_allocSize = count;
 		}
 
@@ -301,7 +342,7 @@ namespace s2
 		{
 			clear();
 			if (m_buffer != nullptr) {
-				free(m_buffer);
+				TAllocator::deallocate(m_buffer);
 				m_buffer = nullptr;
 				m_allocSize = 0;
 			}
@@ -0,0 +1,569 @@
+#pragma once
+
+#define S2_USING_MULTISEARCH
+
+#include "s2string.h"
+
+// Pattern sets up to this size are searched by checking candidate positions directly, which are found with SSE2 when
+// available. Larger sets are compiled into an Aho-Corasick automaton.
+#ifndef S2_MULTISEARCH_SMALL_SET
+#define S2_MULTISEARCH_SMALL_SET 8
+#endif
+
+namespace s2
+{
+	struct multisearchmatch
+	{
+		size_t pattern; // The index of the pattern, in the order they were added
+		size_t pos; // The position in the text where the match starts
+		size_t len; // The length of the match
+	};
+
+	// Searches for many patterns at once, in a single pass over the text. Patterns are added and then compiled once,
+	// after which the same object can be used to search any amount of text. Empty patterns never match.
+	class multisearch
+	{
+	private:
+		struct patterninfo
+		{
+			size_t offset;
+			size_t len;
+			int32_t duplicate; // The next pattern with the same text, or -1
+		};
+
+		bool m_nocase;
+		bool m_compiled = false;
+
+		// The text of all patterns, lowercased in case-insensitive mode
+		string m_text;
+		patterninfo* m_patterns = nullptr;
+		size_t m_numPatterns = 0;
+		size_t m_allocPatterns = 0;
+		size_t m_maxLen = 0;
+
+		// Small sets: the first two bytes of each distinct pattern
+		uint8_t m_pairs[S2_MULTISEARCH_SMALL_SET][2];
+		bool m_pairSingle[S2_MULTISEARCH_SMALL_SET];
+		int m_numPairs = 0;
+		charset m_firstBytes;
+
+		// Large sets: a DFA over byte classes, where bytes that aren't in any pattern share class 0
+		bool m_useAutomaton = false;
+		uint8_t m_classes[256];
+		size_t m_numClasses = 0;
+		int32_t* m_transitions = nullptr;
+		int32_t* m_outputs = nullptr; // The first pattern that ends in each state, or -1
+		int32_t* m_outputLinks = nullptr; // The next state along the fail links that has an output, or -1
+		size_t m_numStates = 0;
+
+	public:
+		multisearch(bool nocase = false);
+		multisearch(std::initializer_list<const char*> patterns, bool nocase = false);
+		multisearch(const multisearch& copy) = delete;
+		~multisearch();
+
+		// Adds and compiles all patterns in a container of strings, such as an s2::list<s2::string>.
+		template<typename TList>
+		explicit multisearch(const TList& patterns, bool nocase = false)
+			: multisearch(nocase)
+		{
+			for (auto& pattern : patterns) {
+				add(pattern);
+			}
+			compile();
+		}
+
+		// Adds a pattern. The patterns must be compiled again before searching.
+		void add(const stringview& pattern);
+		void compile();
+
+		size_t len() const;
+		stringview pattern(size_t index) const;
+
+		// Returns true if any of the patterns occurs in the text.
+		bool contains_any(const stringview& text) const;
+
+		// Finds the match that starts first. When multiple patterns match there, the one added first wins.
+		bool find_first(const stringview& text, multisearchmatch& match) const;
+
+		// Calls the function for every match, including overlapping ones. Matches that overlap are not reported in any
+		// particular order.
+		template<typename TFunc>
+		void find_all(const stringview& text, TFunc&& func) const
+		{
+			auto f = &func;
+			scan(text, [](const multisearchmatch& match, void* userdata) {
+				(*(decltype(f))userdata)(match);
+				return true;
+			}, (void*)f);
+		}
+
+		// Returns the amount of matches, including overlapping ones.
+		size_t count(const stringview& text) const;
+
+	private:
+		typedef bool (*scanfunc)(const multisearchmatch& match, void* userdata);
+
+		void clear_compiled();
+		void compile_small();
+		void compile_automaton();
+
+		// Calls func for each match until it returns false
+		void scan(const stringview& text, scanfunc func, void* userdata) const;
+		bool scan_small_at(const char* text, size_t len, size_t pos, scanfunc func, void* userdata) const;
+		void scan_small(const char* text, size_t len, scanfunc func, void* userdata) const;
+		void scan_automaton(const char* text, size_t len, scanfunc func, void* userdata) const;
+	};
+}
+
+#if defined(S2_IMPL)
+#include <cassert>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if !defined(S2_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define S2_MULTISEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace s2
+{
+	static inline char multisearch_lower(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+	}
+
+#if defined(S2_MULTISEARCH_SSE2)
+	static inline int multisearch_bitscan(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	static inline __m128i multisearch_lower_sse2(__m128i v)
+	{
+		// Bytes above 0x7F are negative, so they are never seen as uppercase
+		__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+		return _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+	}
+#endif
+}
+
+s2::multisearch::multisearch(bool nocase)
+	: m_nocase(nocase)
+{
+}
+
+s2::multisearch::multisearch(std::initializer_list<const char*> patterns, bool nocase)
+	: m_nocase(nocase)
+{
+	for (const char* pattern : patterns) {
+		add(pattern);
+	}
+	compile();
+}
+
+s2::multisearch::~multisearch()
+{
+	clear_compiled();
+	if (m_patterns != nullptr) {
+		S2_FREE(m_patterns);
+	}
+}
+
+void s2::multisearch::add(const s2::stringview& pattern)
+{
+	if (m_numPatterns == m_allocPatterns) {
+		m_allocPatterns = m_allocPatterns == 0 ? 16 : m_allocPatterns * 2;
+		m_patterns = (patterninfo*)S2_REALLOC(m_patterns, m_allocPatterns * sizeof(patterninfo));
+	}
+
+	patterninfo& info = m_patterns[m_numPatterns++];
+	info.offset = m_text.len();
+	info.len = pattern.len();
+	info.duplicate = -1;
+
+	m_text.append(pattern.c_str(), pattern.len());
+	if (m_nocase) {
+		char* p = (char*)m_text.c_str() + info.offset;
+		memlower(p, p, info.len);
+	}
+
+	m_compiled = false;
+}
+
+void s2::multisearch::compile()
+{
+	clear_compiled();
+
+	m_maxLen = 0;
+	for (size_t i = 0; i < m_numPatterns; i++) {
+		patterninfo& info = m_patterns[i];
+		info.duplicate = -1;
+		if (info.len > m_maxLen) {
+			m_maxLen = info.len;
+		}
+	}
+
+	if (m_numPatterns <= S2_MULTISEARCH_SMALL_SET) {
+		compile_small();
+	} else {
+		compile_automaton();
+	}
+	m_compiled = true;
+}
+
+size_t s2::multisearch::len() const
+{
+	return m_numPatterns;
+}
+
+s2::stringview s2::multisearch::pattern(size_t index) const
+{
+	const patterninfo& info = m_patterns[index];
+	return stringview(m_text.c_str() + info.offset, info.len);
+}
+
+bool s2::multisearch::contains_any(const s2::stringview& text) const
+{
+	bool found = false;
+	scan(text, [](const multisearchmatch&, void* userdata) {
+		*(bool*)userdata = true;
+		return false;
+	}, &found);
+	return found;
+}
+
+bool s2::multisearch::find_first(const s2::stringview& text, s2::multisearchmatch& match) const
+{
+	// Empty patterns never match, so a length of 0 means nothing was found
+	multisearchmatch first = { 0, 0, 0 };
+	scan(text, [](const multisearchmatch& m, void* userdata) {
+		*(multisearchmatch*)userdata = m;
+		return false;
+	}, &first);
+
+	if (first.len == 0) {
+		return false;
+	}
+
+	if (m_useAutomaton) {
+		// The automaton reports matches by where they end, so a longer match could still start earlier. Such a match
+		// must lie between the end of this match minus the longest pattern, and the start of this match plus the
+		// longest pattern, so only that window has to be searched again.
+		size_t end = first.pos + first.len;
+		size_t windowStart = end > m_maxLen ? end - m_maxLen : 0;
+		size_t windowEnd = first.pos + m_maxLen;
+		if (windowEnd > text.len()) {
+			windowEnd = text.len();
+		}
+
+		struct bestmatch
+		{
+			multisearchmatch* match;
+			size_t offset;
+		};
+		bestmatch best = { &first, windowStart };
+
+		scan(stringview(text.c_str() + windowStart, windowEnd - windowStart), [](const multisearchmatch& m, void* userdata) {
+			bestmatch& best = *(bestmatch*)userdata;
+			size_t pos = m.pos + best.offset;
+			if (pos < best.match->pos || (pos == best.match->pos && m.pattern < best.match->pattern)) {
+				*best.match = m;
+				best.match->pos = pos;
+			}
+			return true;
+		}, &best);
+	}
+
+	match = first;
+	return true;
+}
+
+size_t s2::multisearch::count(const s2::stringview& text) const
+{
+	size_t ret = 0;
+	scan(text, [](const multisearchmatch&, void* userdata) {
+		(*(size_t*)userdata)++;
+		return true;
+	}, &ret);
+	return ret;
+}
+
+void s2::multisearch::clear_compiled()
+{
+	if (m_transitions != nullptr) {
+		S2_FREE(m_transitions);
+		S2_FREE(m_outputs);
+		S2_FREE(m_outputLinks);
+		m_transitions = nullptr;
+		m_outputs = nullptr;
+		m_outputLinks = nullptr;
+	}
+	m_numStates = 0;
+	m_numClasses = 0;
+	m_numPairs = 0;
+	m_firstBytes = charset();
+	m_useAutomaton = false;
+	m_compiled = false;
+}
+
+void s2::multisearch::compile_small()
+{
+	for (size_t i = 0; i < m_numPatterns; i++) {
+		const patterninfo& info = m_patterns[i];
+		if (info.len == 0) {
+			continue;
+		}
+
+		const char* p = m_text.c_str() + info.offset;
+		uint8_t first = (uint8_t)p[0];
+		uint8_t second = info.len > 1 ? (uint8_t)p[1] : 0;
+		bool single = info.len == 1;
+
+		m_firstBytes.add(p[0]);
+		if (m_nocase && first >= 'a' && first <= 'z') {
+			m_firstBytes.add(p[0] - ('a' - 'A'));
+		}
+
+		bool exists = false;
+		for (int j = 0; j < m_numPairs; j++) {
+			if (m_pairs[j][0] == first && (m_pairSingle[j] || (!single && m_pairs[j][1] == second))) {
+				exists = true;
+				break;
+			}
+		}
+		if (!exists) {
+			m_pairs[m_numPairs][0] = first;
+			m_pairs[m_numPairs][1] = second;
+			m_pairSingle[m_numPairs] = single;
+			m_numPairs++;
+		}
+	}
+}
+
+void s2::multisearch::compile_automaton()
+{
+	m_useAutomaton = true;
+
+	// Give every byte that appears in a pattern its own class, and fold the case of letters into the same class. All
+	// other bytes share class 0, unless every byte value appears in a pattern.
+	bool used[256] = {};
+	size_t numUsed = 0;
+	for (size_t i = 0; i < m_text.len(); i++) {
+		uint8_t c = (uint8_t)m_text.c_str()[i];
+		if (!used[c]) {
+			used[c] = true;
+			numUsed++;
+		}
+	}
+
+	memset(m_classes, 0, sizeof(m_classes));
+	m_numClasses = numUsed < 256 ? 1 : 0;
+	for (int c = 0; c < 256; c++) {
+		if (used[c]) {
+			m_classes[c] = (uint8_t)m_numClasses++;
+		}
+	}
+	if (m_nocase) {
+		for (int c = 'A'; c <= 'Z'; c++) {
+			m_classes[c] = m_classes[c + ('a' - 'A')];
+		}
+	}
+
+	// Build the trie, where a missing transition is -1
+	size_t allocStates = m_text.len() + 1;
+	m_transitions = (int32_t*)S2_MALLOC(allocStates * m_numClasses * sizeof(int32_t));
+	m_outputs = (int32_t*)S2_MALLOC(allocStates * sizeof(int32_t));
+	m_outputLinks = (int32_t*)S2_MALLOC(allocStates * sizeof(int32_t));
+	memset(m_transitions, 0xFF, allocStates * m_numClasses * sizeof(int32_t));
+	m_outputs[0] = -1;
+	m_outputLinks[0] = -1;
+	m_numStates = 1;
+
+	for (size_t i = 0; i < m_numPatterns; i++) {
+		patterninfo& info = m_patterns[i];
+		if (info.len == 0) {
+			continue;
+		}
+
+		const char* p = m_text.c_str() + info.offset;
+		int32_t state = 0;
+		for (size_t j = 0; j < info.len; j++) {
+			int32_t& next = m_transitions[state * m_numClasses + m_classes[(uint8_t)p[j]]];
+			if (next == -1) {
+				next = (int32_t)m_numStates++;
+				m_outputs[next] = -1;
+				m_outputLinks[next] = -1;
+			}
+			state = next;
+		}
+
+		if (m_outputs[state] == -1) {
+			m_outputs[state] = (int32_t)i;
+		} else {
+			// Keep duplicates in a chain, so they are all reported
+			int32_t last = m_outputs[state];
+			while (m_patterns[last].duplicate != -1) {
+				last = m_patterns[last].duplicate;
+			}
+			m_patterns[last].duplicate = (int32_t)i;
+		}
+	}
+
+	// Turn the trie into a DFA by following the fail links breadth first. States at a lower depth are always finished
+	// before the states that fail to them.
+	int32_t* fail = (int32_t*)S2_MALLOC(m_numStates * sizeof(int32_t));
+	int32_t* queue = (int32_t*)S2_MALLOC(m_numStates * sizeof(int32_t));
+	size_t queueStart = 0;
+	size_t queueEnd = 0;
+
+	for (size_t c = 0; c < m_numClasses; c++) {
+		int32_t& next = m_transitions[c];
+		if (next == -1) {
+			next = 0;
+		} else {
+			fail[next] = 0;
+			queue[queueEnd++] = next;
+		}
+	}
+
+	while (queueStart < queueEnd) {
+		int32_t state = queue[queueStart++];
+		int32_t* row = m_transitions + state * m_numClasses;
+		const int32_t* failRow = m_transitions + fail[state] * m_numClasses;
+		for (size_t c = 0; c < m_numClasses; c++) {
+			int32_t next = row[c];
+			if (next == -1) {
+				row[c] = failRow[c];
+				continue;
+			}
+
+			int32_t f = failRow[c];
+			fail[next] = f;
+			m_outputLinks[next] = m_outputs[f] != -1 ? f : m_outputLinks[f];
+			queue[queueEnd++] = next;
+		}
+	}
+
+	S2_FREE(fail);
+	S2_FREE(queue);
+}
+
+void s2::multisearch::scan(const s2::stringview& text, scanfunc func, void* userdata) const
+{
+	assert(m_compiled);
+	if (!m_compiled || m_maxLen == 0) {
+		return;
+	}
+
+	if (m_useAutomaton) {
+		scan_automaton(text.c_str(), text.len(), func, userdata);
+	} else {
+		scan_small(text.c_str(), text.len(), func, userdata);
+	}
+}
+
+bool s2::multisearch::scan_small_at(const char* text, size_t len, size_t pos, scanfunc func, void* userdata) const
+{
+	for (size_t i = 0; i < m_numPatterns; i++) {
+		const patterninfo& info = m_patterns[i];
+		if (info.len == 0 || info.len > len - pos) {
+			continue;
+		}
+
+		const char* p = m_text.c_str() + info.offset;
+		const char* t = text + pos;
+		bool equal = true;
+		if (m_nocase) {
+			for (size_t j = 0; j < info.len; j++) {
+				if (multisearch_lower(t[j]) != p[j]) {
+					equal = false;
+					break;
+				}
+			}
+		} else {
+			equal = !memcmp(t, p, info.len);
+		}
+
+		if (equal && !func({ i, pos, info.len }, userdata)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void s2::multisearch::scan_small(const char* text, size_t len, scanfunc func, void* userdata) const
+{
+	size_t i = 0;
+
+#if defined(S2_MULTISEARCH_SSE2)
+	// Compare 16 positions at once against the first two bytes of every pattern, and only check the full patterns at
+	// the positions where those match. The second load reads one byte further, so stop a byte early.
+	__m128i firsts[S2_MULTISEARCH_SMALL_SET];
+	__m128i seconds[S2_MULTISEARCH_SMALL_SET];
+	for (int j = 0; j < m_numPairs; j++) {
+		firsts[j] = _mm_set1_epi8((char)m_pairs[j][0]);
+		seconds[j] = _mm_set1_epi8((char)m_pairs[j][1]);
+	}
+
+	for (; i + 17 <= len; i += 16) {
+		__m128i block0 = _mm_loadu_si128((const __m128i*)(text + i));
+		__m128i block1 = _mm_loadu_si128((const __m128i*)(text + i + 1));
+		if (m_nocase) {
+			block0 = multisearch_lower_sse2(block0);
+			block1 = multisearch_lower_sse2(block1);
+		}
+
+		uint32_t mask = 0;
+		for (int j = 0; j < m_numPairs; j++) {
+			__m128i eq = _mm_cmpeq_epi8(block0, firsts[j]);
+			if (!m_pairSingle[j]) {
+				eq = _mm_and_si128(eq, _mm_cmpeq_epi8(block1, seconds[j]));
+			}
+			mask |= (uint32_t)_mm_movemask_epi8(eq);
+		}
+
+		while (mask != 0) {
+			int bit = multisearch_bitscan(mask);
+			mask &= mask - 1;
+			if (!scan_small_at(text, len, i + bit, func, userdata)) {
+				return;
+			}
+		}
+	}
+#endif
+
+	for (; i < len; i++) {
+		if (m_firstBytes.contains(text[i]) && !scan_small_at(text, len, i, func, userdata)) {
+			return;
+		}
+	}
+}
+
+void s2::multisearch::scan_automaton(const char* text, size_t len, scanfunc func, void* userdata) const
+{
+	int32_t state = 0;
+	for (size_t i = 0; i < len; i++) {
+		state = m_transitions[state * m_numClasses + m_classes[(uint8_t)text[i]]];
+
+		int32_t out = m_outputs[state] != -1 ? state : m_outputLinks[state];
+		while (out != -1) {
+			for (int32_t p = m_outputs[out]; p != -1; p = m_patterns[p].duplicate) {
+				size_t patternLen = m_patterns[p].len;
+				if (!func({ (size_t)p, i + 1 - patternLen, patternLen }, userdata)) {
+					return;
+				}
+			}
+			out = m_outputLinks[out];
+		}
+	}
+}
+#endif
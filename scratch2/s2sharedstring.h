@@ -0,0 +1,305 @@
+#pragma once
+
+#define S2_USING_SHAREDSTRING
+
+#include "s2string.h"
+
+namespace s2
+{
+	// An immutable string with an atomically reference counted buffer. Copying only increments the reference count, so
+	// the same text can be passed between threads and containers without copying it. Functions that change the string
+	// first detach it, giving it its own copy of the buffer if it's shared.
+	class sharedstring
+	{
+	private:
+		struct block
+		{
+			long refs;
+			size_t len;
+
+			inline char* data() { return (char*)(this + 1); }
+		};
+
+		block* m_block = nullptr;
+
+	public:
+		sharedstring();
+		sharedstring(const char* sz);
+		sharedstring(const char* sz, size_t len);
+		sharedstring(const string& str);
+		sharedstring(const stringview& str);
+		sharedstring(const sharedstring& copy);
+		sharedstring(sharedstring&& other);
+		~sharedstring();
+
+		sharedstring& operator =(const char* sz);
+		sharedstring& operator =(const sharedstring& copy);
+		sharedstring& operator =(sharedstring&& other);
+
+		inline size_t len() const { return m_block == nullptr ? 0 : m_block->len; }
+		inline const char* c_str() const { return m_block == nullptr ? "" : m_block->data(); }
+		inline bool is_null() const { return m_block == nullptr; }
+		inline stringview view() const { return stringview(c_str(), len()); }
+
+		inline operator const char*() const { return c_str(); }
+		inline operator stringview() const { return view(); }
+
+		// Returns the amount of sharedstring objects sharing this buffer, or 0 if the string is null.
+		int count() const;
+
+		// Returns a copy as a regular string.
+		string to_string() const;
+
+		// Makes sure this string has its own buffer, and returns it for writing. The length can't be changed this way.
+		char* detach();
+
+		void append(const char* sz);
+		void append(const char* sz, size_t len);
+		void append(const stringview& str);
+
+		bool operator ==(const char* sz) const;
+		bool operator ==(const sharedstring& other) const;
+		bool operator !=(const char* sz) const;
+		bool operator !=(const sharedstring& other) const;
+
+	private:
+		void assign(const char* sz, size_t len);
+		void release();
+		static block* allocate(size_t len);
+	};
+}
+
+#if defined(S2_IMPL)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace s2
+{
+	static inline void sharedstring_increment(long* refs)
+	{
+#if defined(_MSC_VER)
+		_InterlockedIncrement(refs);
+#else
+		__atomic_fetch_add(refs, 1, __ATOMIC_RELAXED);
+#endif
+	}
+
+	// Returns the new reference count
+	static inline long sharedstring_decrement(long* refs)
+	{
+#if defined(_MSC_VER)
+		return _InterlockedDecrement(refs);
+#else
+		return __atomic_sub_fetch(refs, 1, __ATOMIC_ACQ_REL);
+#endif
+	}
+
+	static inline long sharedstring_load(const long* refs)
+	{
+#if defined(_MSC_VER)
+		return *(const volatile long*)refs;
+#else
+		return __atomic_load_n(refs, __ATOMIC_ACQUIRE);
+#endif
+	}
+}
+
+s2::sharedstring::sharedstring()
+{
+}
+
+s2::sharedstring::sharedstring(const char* sz)
+{
+	if (sz != nullptr) {
+		assign(sz, strlen(sz));
+	}
+}
+
+s2::sharedstring::sharedstring(const char* sz, size_t len)
+{
+	if (sz != nullptr) {
+		assign(sz, len);
+	}
+}
+
+s2::sharedstring::sharedstring(const s2::string& str)
+{
+	if (!str.is_null()) {
+		assign(str.c_str(), str.len());
+	}
+}
+
+s2::sharedstring::sharedstring(const s2::stringview& str)
+{
+	assign(str.c_str(), str.len());
+}
+
+s2::sharedstring::sharedstring(const s2::sharedstring& copy)
+{
+	m_block = copy.m_block;
+	if (m_block != nullptr) {
+		sharedstring_increment(&m_block->refs);
+	}
+}
+
+s2::sharedstring::sharedstring(s2::sharedstring&& other)
+{
+	m_block = other.m_block;
+	other.m_block = nullptr;
+}
+
+s2::sharedstring::~sharedstring()
+{
+	release();
+}
+
+s2::sharedstring& s2::sharedstring::operator =(const char* sz)
+{
+	// The text may point into the current buffer, so only release it once it's copied
+	block* b = m_block;
+	m_block = nullptr;
+	if (sz != nullptr) {
+		assign(sz, strlen(sz));
+	}
+	if (b != nullptr && sharedstring_decrement(&b->refs) == 0) {
+		S2_FREE(b);
+	}
+	return *this;
+}
+
+s2::sharedstring& s2::sharedstring::operator =(const s2::sharedstring& copy)
+{
+	if (copy.m_block != nullptr) {
+		sharedstring_increment(&copy.m_block->refs);
+	}
+	release();
+	m_block = copy.m_block;
+	return *this;
+}
+
+s2::sharedstring& s2::sharedstring::operator =(s2::sharedstring&& other)
+{
+	if (this != &other) {
+		release();
+		m_block = other.m_block;
+		other.m_block = nullptr;
+	}
+	return *this;
+}
+
+int s2::sharedstring::count() const
+{
+	if (m_block == nullptr) {
+		return 0;
+	}
+	return (int)sharedstring_load(&m_block->refs);
+}
+
+s2::string s2::sharedstring::to_string() const
+{
+	if (m_block == nullptr) {
+		return s2::string();
+	}
+	return s2::string(m_block->data(), m_block->len);
+}
+
+char* s2::sharedstring::detach()
+{
+	if (m_block == nullptr) {
+		assign("", 0);
+	} else if (sharedstring_load(&m_block->refs) > 1) {
+		block* b = m_block;
+		m_block = nullptr;
+		assign(b->data(), b->len);
+		if (sharedstring_decrement(&b->refs) == 0) {
+			S2_FREE(b);
+		}
+	}
+	return m_block->data();
+}
+
+void s2::sharedstring::append(const char* sz)
+{
+	append(sz, strlen(sz));
+}
+
+void s2::sharedstring::append(const char* sz, size_t len)
+{
+	if (m_block == nullptr) {
+		assign(sz, len);
+		return;
+	}
+
+	size_t oldLen = m_block->len;
+	const char* data = m_block->data();
+	if (sharedstring_load(&m_block->refs) == 1) {
+		// Nobody else can see this buffer, so it can grow in place. Text from this buffer itself moves along with it.
+		bool inside = sz >= data && sz <= data + oldLen;
+		size_t offset = inside ? sz - data : 0;
+		m_block = (block*)S2_REALLOC(m_block, sizeof(block) + oldLen + len + 1);
+		memcpy(m_block->data() + oldLen, inside ? m_block->data() + offset : sz, len);
+	} else {
+		block* b = allocate(oldLen + len);
+		memcpy(b->data(), data, oldLen);
+		memcpy(b->data() + oldLen, sz, len);
+		release();
+		m_block = b;
+	}
+
+	m_block->len = oldLen + len;
+	m_block->data()[m_block->len] = '\0';
+}
+
+void s2::sharedstring::append(const s2::stringview& str)
+{
+	append(str.c_str(), str.len());
+}
+
+bool s2::sharedstring::operator ==(const char* sz) const
+{
+	return view() == sz;
+}
+
+bool s2::sharedstring::operator ==(const s2::sharedstring& other) const
+{
+	if (m_block == other.m_block) {
+		return true;
+	}
+	return view() == other.view();
+}
+
+bool s2::sharedstring::operator !=(const char* sz) const
+{
+	return !operator ==(sz);
+}
+
+bool s2::sharedstring::operator !=(const s2::sharedstring& other) const
+{
+	return !operator ==(other);
+}
+
+void s2::sharedstring::assign(const char* sz, size_t len)
+{
+	block* b = allocate(len);
+	memcpy(b->data(), sz, len);
+	b->data()[len] = '\0';
+	m_block = b;
+}
+
+void s2::sharedstring::release()
+{
+	if (m_block != nullptr && sharedstring_decrement(&m_block->refs) == 0) {
+		S2_FREE(m_block);
+	}
+	m_block = nullptr;
+}
+
+s2::sharedstring::block* s2::sharedstring::allocate(size_t len)
+{
+	block* b = (block*)S2_MALLOC(sizeof(block) + len + 1);
+	b->refs = 1;
+	b->len = len;
+	return b;
+}
+#endif
@@ -6,18 +6,122 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <initializer_list>
+
+#ifndef S2_MALLOC
+#define S2_MALLOC(size) ::malloc(size)
+#endif
+#ifndef S2_REALLOC
+#define S2_REALLOC(ptr, size) ::realloc(ptr, size)
+#endif
+#ifndef S2_FREE
+#define S2_FREE(ptr) ::free(ptr)
+#endif
+
+// Strings that fit in this many bytes (including the null terminator) are stored inside the string object itself
+// instead of on the heap.
+#ifndef S2_STRING_LOCAL_SIZE
+#define S2_STRING_LOCAL_SIZE 24
+#endif
 
 namespace s2
 {
 	class stringsplit;
 	class stringview;
+	class splitview;
+
+	enum class parseerror
+	{
+		none,
+		invalid, // There is no number at the start of the input
+		out_of_range, // The number does not fit in the requested type
+	};
+
+	// The result of parsing a number. ptr points to the first character after the number. On error the value is left
+	// unchanged, and ptr points to the start of the input when it's invalid, or to the end of the number when it's out
+	// of range.
+	struct parseresult
+	{
+		const char* ptr;
+		parseerror error;
+
+		inline explicit operator bool() const { return error == parseerror::none; }
+	};
+
+	// A set of characters stored as a 256-bit table, so that checking whether a character is in the set is a single
+	// lookup instead of a search through a list of characters. It can be built at compile time.
+	class charset
+	{
+	private:
+		uint64_t m_bits[4] = { 0, 0, 0, 0 };
+
+	public:
+		constexpr inline charset()
+		{
+		}
+
+		constexpr inline charset(const char* chars)
+		{
+			while (chars != nullptr && *chars != '\0') {
+				add(*chars++);
+			}
+		}
+
+		constexpr inline void add(char c)
+		{
+			uint8_t u = (uint8_t)c;
+			m_bits[u >> 6] |= 1ull << (u & 63);
+		}
+
+		constexpr inline bool contains(char c) const
+		{
+			uint8_t u = (uint8_t)c;
+			return (m_bits[u >> 6] >> (u & 63)) & 1;
+		}
+
+		constexpr inline bool is_empty() const { return (m_bits[0] | m_bits[1] | m_bits[2] | m_bits[3]) == 0; }
+
+		// Returns the first character in the range that is in the set, or end if there is none.
+		inline const char* find(const char* p, const char* end) const
+		{
+			while (p < end && !contains(*p)) {
+				p++;
+			}
+			return p;
+		}
+
+		// Returns the first character in the range that is not in the set, or end if there is none.
+		inline const char* find_not(const char* p, const char* end) const
+		{
+			while (p < end && contains(*p)) {
+				p++;
+			}
+			return p;
+		}
+
+		// The characters that trim() removes by default.
+		static constexpr inline charset whitespace() { return charset("\n\r\t "); }
+	};
 
 	class string
 	{
 	friend class stringsplit;
 
+	public:
+		struct replacepair
+		{
+			const char* find;
+			const char* replace;
+		};
+
 	private:
-		char* m_buffer;
+		// The buffer is local when m_allocSize is at most S2_STRING_LOCAL_SIZE, and null when m_allocSize is 0. We don't
+		// keep a pointer to m_local around, so that containers are free to move strings around in memory with memmove.
+		union
+		{
+			char* m_heap;
+			char m_local[S2_STRING_LOCAL_SIZE];
+		};
 		size_t m_length;
 		size_t m_allocSize;
 
@@ -27,6 +131,7 @@ namespace s2
 		string(const char* sz, size_t len);
 		string(const char* sz, size_t start, size_t len);
 		string(const string& str);
+		string(string&& str);
 		~string();
 
 		size_t len() const;
@@ -38,6 +143,8 @@ namespace s2
 		int indexof(const char* sz) const;
 		int lastindexof(char c) const;
 		int lastindexof(const char* sz) const;
+		int indexof_nocase(const char* sz) const;
+		int lastindexof_nocase(const char* sz) const;
 
 		bool contains(const char* sz) const;
 		bool contains_nocase(const char* sz) const;
@@ -45,6 +152,9 @@ namespace s2
 		bool endswith(const char* sz) const;
 		stringsplit split(const char* delim, int limit = 0) const;
 		stringsplit commandlinesplit() const;
+		splitview split_view(const char* delim, int limit = 0) const;
+		// Splits on every character that is in the given set.
+		splitview split_view(const charset& delims, int limit = 0) const;
 
 		string substr(intptr_t start) const;
 		string substr(intptr_t start, intptr_t len) const;
@@ -54,6 +164,9 @@ namespace s2
 		void append(const char* sz);
 		void append(const char* sz, size_t len);
 		void append(const char* sz, size_t start, size_t len);
+		void append(const string& str);
+		void append(string&& str);
+		void append(const stringview& str);
 
 		void insert(const char* sz, size_t pos);
 		void insert(const char* sz, size_t pos, size_t len);
@@ -62,24 +175,59 @@ namespace s2
 		string replace(char find, char replace) const;
 		string replace(const char* find, const char* replace) const;
 		string replace(const char* findchars, char replace) const;
+		string replace(const charset& findchars, char replace) const;
+
+		// Replaces all occurrences of every pair's find string with its replace string in a single pass. Where multiple
+		// find strings match at the same position, the first pair in the list wins. Replaced text is not searched again.
+		string replace_all(std::initializer_list<replacepair> pairs) const;
+		string replace_all(const replacepair* pairs, size_t count) const;
 
 		void setf(const char* format, ...);
 		void appendf(const char* format, ...);
 
+		void append_int(int64_t value);
+		void append_uint(uint64_t value);
+		void append_hex(uint64_t value, bool uppercase = false);
+		void append_double(double value);
+		void append_float(float value);
+
 		string& operator =(const char* sz);
 		string& operator =(const string& str);
+		string& operator =(string&& str);
 
 		string& operator +=(const char* sz);
 		string& operator +=(const string& str);
+		string& operator +=(string&& str);
 
-		string operator +(const char* sz) const;
-		string operator +(const string& str) const;
+		string operator +(const char* sz) const &;
+		string operator +(const string& str) const &;
+		string operator +(char c) const &;
+
+		// Appends to this string and returns it, which re-uses the buffer of temporaries when chaining concatenations.
+		string operator +(const char* sz) &&;
+		string operator +(const string& str) &&;
+		string operator +(char c) &&;
+		string operator +(string&& str) const &;
+		string operator +(string&& str) &&;
 
 		string trim() const;
 		string trim(const char* sz) const;
+		string trim(const charset& chars) const;
+
+		// Returns a view of this string without the characters at the start and end, without allocating anything.
+		stringview trim_view() const;
+		stringview trim_view(const char* sz) const;
+		stringview trim_view(const charset& chars) const;
+
+		// Removes the characters at the start and end from this string, keeping the same buffer.
+		void trim_inplace();
+		void trim_inplace(const char* sz);
+		void trim_inplace(const charset& chars);
 
 		string tolower() const;
 		string toupper() const;
+		void make_lower();
+		void make_upper();
 
 		int as_int() const;
 		int64_t as_large_int() const;
@@ -89,11 +237,43 @@ namespace s2
 		double as_double() const;
 		bool as_bool() const;
 
+		parseresult parse(int32_t& value) const;
+		parseresult parse(int64_t& value) const;
+		parseresult parse(uint32_t& value) const;
+		parseresult parse(uint64_t& value) const;
+		parseresult parse(float& value) const;
+		parseresult parse(double& value) const;
+
+		// Returns the same hash as the default hashtable and set hashers give for this string, as long as it doesn't
+		// contain any null characters.
+		uint64_t hash() const;
+
+		// Compares the bytes of both strings, returning a negative number, 0, or a positive number like memcmp. A null
+		// string is the same as an empty string.
+		int compare(const char* sz) const;
+		int compare(const string& str) const;
+		int compare(const stringview& str) const;
+
 		bool operator ==(const char* sz) const;
 		bool operator ==(const string& str) const;
+		bool operator ==(const stringview& str) const;
 
 		bool operator !=(const char* sz) const;
 		bool operator !=(const string& str) const;
+		bool operator !=(const stringview& str) const;
+
+		inline bool operator <(const char* sz) const { return compare(sz) < 0; }
+		inline bool operator <(const string& str) const { return compare(str) < 0; }
+		inline bool operator <(const stringview& str) const { return compare(str) < 0; }
+		inline bool operator <=(const char* sz) const { return compare(sz) <= 0; }
+		inline bool operator <=(const string& str) const { return compare(str) <= 0; }
+		inline bool operator <=(const stringview& str) const { return compare(str) <= 0; }
+		inline bool operator >(const char* sz) const { return compare(sz) > 0; }
+		inline bool operator >(const string& str) const { return compare(str) > 0; }
+		inline bool operator >(const stringview& str) const { return compare(str) > 0; }
+		inline bool operator >=(const char* sz) const { return compare(sz) >= 0; }
+		inline bool operator >=(const string& str) const { return compare(str) >= 0; }
+		inline bool operator >=(const stringview& str) const { return compare(str) >= 0; }
 
 		operator const char*() const;
 
@@ -105,15 +285,107 @@ namespace s2
 		void ensure_not_null();
 
 	private:
+		inline bool is_local() const { return m_allocSize <= S2_STRING_LOCAL_SIZE; }
+		inline char* buffer() { return m_allocSize == 0 ? nullptr : (is_local() ? m_local : m_heap); }
+		inline const char* buffer() const { return m_allocSize == 0 ? nullptr : (is_local() ? m_local : m_heap); }
+
+		void take_memory(string& str);
+
 		void resize_memory(size_t size);
 	};
 
 	bool operator ==(const char* sz, const string& str);
+	bool operator !=(const char* sz, const string& str);
+	bool operator <(const char* sz, const string& str);
+	bool operator <=(const char* sz, const string& str);
+	bool operator >(const char* sz, const string& str);
+	bool operator >=(const char* sz, const string& str);
 
 	string operator +(const char* lhs, const string& rhs);
+	string operator +(const char* lhs, string&& rhs);
 
 	string strprintf(const char* format, ...);
 
+	// Finds the first occurrence of the given character in the buffer, or nullptr if it's not found. The buffer does not
+	// have to be null-terminated. This uses SSE2 or AVX2 when available.
+	const char* memfind(const char* haystack, size_t len, char c);
+	// Finds the last occurrence of the given character in the buffer, or nullptr if it's not found.
+	const char* memrfind(const char* haystack, size_t len, char c);
+	// Finds the first occurrence of the given needle in the buffer, or nullptr if it's not found. An empty needle is
+	// found at the start of the buffer.
+	const char* memfind(const char* haystack, size_t len, const char* needle, size_t needleLen);
+	// Finds the last occurrence of the given needle in the buffer, or nullptr if it's not found. An empty needle is
+	// found at the end of the buffer.
+	const char* memrfind(const char* haystack, size_t len, const char* needle, size_t needleLen);
+	// Finds the first occurrence of the given needle in the buffer, ignoring ASCII case.
+	const char* memfind_nocase(const char* haystack, size_t len, const char* needle, size_t needleLen);
+	// Finds the last occurrence of the given needle in the buffer, ignoring ASCII case.
+	const char* memrfind_nocase(const char* haystack, size_t len, const char* needle, size_t needleLen);
+	// Copies the buffer while converting ASCII letters to lowercase or uppercase. Other bytes, including UTF-8, are
+	// copied as-is, and the result does not depend on the locale. The source and destination may be the same.
+	void memlower(char* dst, const char* src, size_t len);
+	void memupper(char* dst, const char* src, size_t len);
+
+	// Writes the number into the buffer without a null terminator, and returns the amount of characters written. The
+	// buffer must have room for at least max_number_length characters. The output does not depend on the locale.
+	static constexpr size_t max_number_length = 32;
+	size_t format_int(char* buffer, int64_t value);
+	size_t format_uint(char* buffer, uint64_t value);
+	size_t format_hex(char* buffer, uint64_t value, bool uppercase = false);
+	// Doubles are written with the shortest digits that parse back to the same value, in the same notation as
+	// JavaScript: plain decimals for numbers from 1e-6 up to 1e21, and scientific notation like 1.5e+300 otherwise.
+	size_t format_double(char* buffer, double value);
+	// Floats are written the same way, with the shortest digits that parse back to the same float.
+	size_t format_float(char* buffer, float value);
+
+	// Parses a number at the start of the given range, similar to std::from_chars. Leading whitespace is not skipped, but
+	// a leading '+' is accepted. Parsing does not depend on the locale, and the input does not have to be
+	// null-terminated. Floating point numbers may also be "inf", "infinity" or "nan", in any case.
+	parseresult parse_number(const char* first, const char* last, int32_t& value);
+	parseresult parse_number(const char* first, const char* last, int64_t& value);
+	parseresult parse_number(const char* first, const char* last, uint32_t& value);
+	parseresult parse_number(const char* first, const char* last, uint64_t& value);
+	parseresult parse_number(const char* first, const char* last, float& value);
+	parseresult parse_number(const char* first, const char* last, double& value);
+
+	// Parses a column of numbers separated by the given character, for example one number per line. Spaces, tabs and
+	// carriage returns around each number are skipped. Up to max numbers are written to out, and count is set to the
+	// amount written. Parsing stops at the first value that fails to parse, which is then reported in the result. If
+	// max is reached first, ptr points to where parsing can continue.
+	template<typename T>
+	parseresult parse_numbers(const char* first, const char* last, char separator, T* out, size_t max, size_t& count)
+	{
+		count = 0;
+		const char* p = first;
+		while (count < max) {
+			while (p < last && *p != separator && (*p == ' ' || *p == '\t' || *p == '\r')) {
+				p++;
+			}
+			if (p == last) {
+				break;
+			}
+
+			parseresult res = parse_number(p, last, out[count]);
+			if (res.error != parseerror::none) {
+				return res;
+			}
+			count++;
+
+			p = res.ptr;
+			while (p < last && *p != separator && (*p == ' ' || *p == '\t' || *p == '\r')) {
+				p++;
+			}
+			if (p == last) {
+				break;
+			}
+			if (*p != separator) {
+				return { p, parseerror::invalid };
+			}
+			p++;
+		}
+		return { p, parseerror::none };
+	}
+
 	class stringsplit
 	{
 	private:
@@ -173,13 +445,210 @@ namespace s2
 			m_len = other.m_len;
 		}
 
-		inline operator string() const { return m_str; }
+		inline operator string() const { return string(m_str, m_len); }
 		constexpr inline operator const char* () const { return m_str; }
+
+		// Note that the view is not guaranteed to be null-terminated, for example when it's a slice of a larger string.
+		// Always use len() together with c_str().
 		constexpr inline const char* c_str() const { return m_str; }
 		constexpr inline size_t len() const { return m_len; }
 
-		inline bool operator==(const char* str) const { return !strcmp(m_str, str); }
-		inline bool operator!=(const char* str) const { return !!strcmp(m_str, str); }
+		int indexof(char c) const;
+		int indexof(const stringview& sz) const;
+		int lastindexof(char c) const;
+		int lastindexof(const stringview& sz) const;
+		int indexof_nocase(const char* sz) const;
+		int lastindexof_nocase(const char* sz) const;
+
+		bool contains(const stringview& sz) const;
+		bool contains_nocase(const char* sz) const;
+		bool startswith(const stringview& sz) const;
+		bool endswith(const stringview& sz) const;
+
+		splitview split_view(const char* delim, int limit = 0) const;
+		splitview split_view(const charset& delims, int limit = 0) const;
+
+		// Returns a view of a part of this view. A negative start counts from the end, and the length is clamped.
+		stringview substr(intptr_t start) const;
+		stringview substr(intptr_t start, intptr_t len) const;
+
+		stringview trim() const;
+		stringview trim(const char* sz) const;
+		stringview trim(const charset& chars) const;
+
+		// Writes the text with ASCII letters converted to lowercase or uppercase into the given buffer, which must be at
+		// least len() bytes. No null terminator is written.
+		inline void lower_to(char* buffer) const { memlower(buffer, m_str, m_len); }
+		inline void upper_to(char* buffer) const { memupper(buffer, m_str, m_len); }
+
+		int as_int() const;
+		int64_t as_large_int() const;
+		uint32_t as_uint() const;
+		uint64_t as_large_uint() const;
+		float as_float() const;
+		double as_double() const;
+		bool as_bool() const;
+
+		inline parseresult parse(int32_t& value) const { return parse_number(m_str, m_str + m_len, value); }
+		inline parseresult parse(int64_t& value) const { return parse_number(m_str, m_str + m_len, value); }
+		inline parseresult parse(uint32_t& value) const { return parse_number(m_str, m_str + m_len, value); }
+		inline parseresult parse(uint64_t& value) const { return parse_number(m_str, m_str + m_len, value); }
+		inline parseresult parse(float& value) const { return parse_number(m_str, m_str + m_len, value); }
+		inline parseresult parse(double& value) const { return parse_number(m_str, m_str + m_len, value); }
+
+		// Returns the same hash as the default hashtable and set hashers give for an equal null-terminated string.
+		uint64_t hash() const;
+
+		// Compares the bytes of both views, returning a negative number, 0, or a positive number like memcmp.
+		inline int compare(const stringview& other) const
+		{
+			int ret = memcmp(m_str, other.m_str, m_len < other.m_len ? m_len : other.m_len);
+			if (ret != 0) {
+				return ret;
+			}
+			return m_len < other.m_len ? -1 : (m_len > other.m_len ? 1 : 0);
+		}
+
+		inline bool equals(const stringview& other) const { return m_len == other.m_len && !memcmp(m_str, other.m_str, m_len); }
+
+		inline bool operator ==(const char* str) const { return equals(str); }
+		inline bool operator ==(const stringview& other) const { return equals(other); }
+		inline bool operator ==(const string& str) const { return equals(str); }
+		inline bool operator !=(const char* str) const { return !equals(str); }
+		inline bool operator !=(const stringview& other) const { return !equals(other); }
+		inline bool operator !=(const string& str) const { return !equals(str); }
+		inline bool operator <(const char* str) const { return compare(str) < 0; }
+		inline bool operator <(const stringview& other) const { return compare(other) < 0; }
+		inline bool operator <(const string& str) const { return compare(str) < 0; }
+		inline bool operator <=(const char* str) const { return compare(str) <= 0; }
+		inline bool operator <=(const stringview& other) const { return compare(other) <= 0; }
+		inline bool operator <=(const string& str) const { return compare(str) <= 0; }
+		inline bool operator >(const char* str) const { return compare(str) > 0; }
+		inline bool operator >(const stringview& other) const { return compare(other) > 0; }
+		inline bool operator >(const string& str) const { return compare(str) > 0; }
+		inline bool operator >=(const char* str) const { return compare(str) >= 0; }
+		inline bool operator >=(const stringview& other) const { return compare(other) >= 0; }
+		inline bool operator >=(const string& str) const { return compare(str) >= 0; }
+	};
+
+	// Hasher for using strings as keys in s2::hashtable and s2::set. It gives the same hashes as the default hashers,
+	// but uses the stored length instead of calling strlen.
+	class stringhasher
+	{
+	public:
+		static inline uint64_t hash(const string& key) { return key.hash(); }
+		static inline uint64_t hash(const stringview& key) { return key.hash(); }
+		static inline uint64_t hash(const char* key) { return stringview(key).hash(); }
+	};
+
+	// Concatenates strings, stringviews, C strings and characters into a new string, allocating once for the total
+	// length. For example, `s2::concat(prefix, ':', id, ':', field)` builds a key with a single allocation.
+	string concat(std::initializer_list<stringview> pieces);
+
+	inline stringview concat_piece(const string& str) { return stringview(str.c_str(), str.len()); }
+	inline stringview concat_piece(const stringview& str) { return str; }
+	inline stringview concat_piece(const char* sz) { return sz != nullptr ? stringview(sz) : stringview(); }
+	inline stringview concat_piece(const char& c) { return stringview(&c, 1); }
+
+	template<typename... TPieces>
+	inline string concat(const TPieces&... pieces)
+	{
+		return concat({ concat_piece(pieces)... });
+	}
+
+	// Splits a string lazily while iterating over it, without allocating any memory. The tokens follow the same rules as
+	// stringsplit: an empty string gives 1 empty token, an empty delimiter gives no tokens, and when limit is above 0, the
+	// last token contains the remainder of the string.
+	class splitview
+	{
+	public:
+		class iterator
+		{
+		private:
+			const splitview* m_split;
+			const char* m_token;
+			size_t m_tokenLen;
+			const char* m_next;
+			int m_index;
+
+		public:
+			inline iterator(const splitview* split, const char* token)
+				: m_split(split), m_token(nullptr), m_tokenLen(0), m_next(token), m_index(-1)
+			{
+				if (token != nullptr) {
+					operator ++();
+				}
+			}
+
+			inline bool operator ==(const iterator& other) const { return m_token == other.m_token; }
+			inline bool operator !=(const iterator& other) const { return m_token != other.m_token; }
+
+			inline iterator& operator ++()
+			{
+				m_token = m_next;
+				m_index++;
+				if (m_token == nullptr) {
+					return *this;
+				}
+
+				const char* end = m_split->m_str + m_split->m_len;
+				const char* delim = nullptr;
+				if (m_split->m_limit <= 0 || m_index + 1 < m_split->m_limit) {
+					if (m_split->m_delim != nullptr) {
+						delim = memfind(m_token, end - m_token, m_split->m_delim, m_split->m_delimLen);
+					} else {
+						delim = m_split->m_delimChars.find(m_token, end);
+						if (delim == end) {
+							delim = nullptr;
+						}
+					}
+				}
+
+				if (delim == nullptr) {
+					m_tokenLen = end - m_token;
+					m_next = nullptr;
+				} else {
+					m_tokenLen = delim - m_token;
+					m_next = delim + m_split->m_delimLen;
+				}
+				return *this;
+			}
+
+			inline stringview operator *() const { return stringview(m_token, m_tokenLen); }
+		};
+
+	private:
+		const char* m_str;
+		size_t m_len;
+		const char* m_delim;
+		size_t m_delimLen;
+		charset m_delimChars;
+		int m_limit;
+
+	public:
+		inline splitview(const char* str, size_t len, const char* delim, int limit = 0)
+			: m_str(str), m_len(len), m_delim(delim), m_delimLen(delim != nullptr ? strlen(delim) : 0), m_limit(limit)
+		{
+		}
+
+		// Splits on any single character in the set instead of on a delimiter string.
+		inline splitview(const char* str, size_t len, const charset& delims, int limit = 0)
+			: m_str(str), m_len(len), m_delim(nullptr), m_delimLen(delims.is_empty() ? 0 : 1), m_delimChars(delims), m_limit(limit)
+		{
+		}
+
+		inline iterator begin() const { return iterator(this, m_delimLen > 0 ? m_str : nullptr); }
+		inline iterator end() const { return iterator(this, nullptr); }
+
+		// Counts the number of tokens by iterating over them.
+		inline size_t len() const
+		{
+			size_t ret = 0;
+			for (auto it = begin(); it != end(); ++it) {
+				ret++;
+			}
+			return ret;
+		}
 	};
 
 #if defined(_MSC_VER)
@@ -191,7 +660,7 @@ namespace s2
 
 	public:
 		str_to_wide(const char* src);
-		inline ~str_to_wide() { free(m_buffer); }
+		inline ~str_to_wide() { S2_FREE(m_buffer); }
 		inline operator const wchar_t* () { return m_buffer; }
 		inline wchar_t* buffer() { return m_buffer; }
 		inline int size() { return m_size; }
@@ -205,7 +674,7 @@ namespace s2
 
 	public:
 		str_to_utf8(const wchar_t* src);
-		inline ~str_to_utf8() { free(m_buffer); }
+		inline ~str_to_utf8() { S2_FREE(m_buffer); }
 		inline operator const char* () { return m_buffer; }
 		inline char* buffer() { return m_buffer; }
 		inline int size() { return m_size; }
@@ -221,690 +690,2825 @@ namespace s2
 #include <cstdarg>
 #include <cstdio>
 #include <cctype>
+#include <cfloat>
+#include <clocale>
+#include <cmath>
 
 #if defined(_MSC_VER)
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 #include <Windows.h>
+#include <intrin.h>
 #endif
 
-const size_t min_buffer_size = 24;
-
-s2::string::string()
-{
-	m_length = 0;
-	m_buffer = nullptr;
-	m_allocSize = 0;
-}
+// The other headers include this one before their own implementation, and use these macros and cpu_has_avx2() for
+// their SIMD code as well.
+#if !defined(S2_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define S2_STRING_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define S2_STRING_AVX2
+#define S2_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define S2_STRING_AVX2
+#define S2_TARGET_AVX2
+#include <immintrin.h>
+#endif
+#endif
 
-s2::string::string(const char* sz)
-	: string(sz, 0, sz != nullptr ? strlen(sz) : 0)
-{
-}
 
-s2::string::string(const char* sz, size_t len)
-	: string(sz, 0, len)
-{
-}
+const size_t min_buffer_size = 24;
+const size_t nocase_horspool_min_length = 32;
 
-s2::string::string(const char* sz, size_t start, size_t len)
-	: string()
+namespace s2
 {
-	if (sz == nullptr) {
-		return;
+	static inline int bitscan_forward(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
 	}
-	m_length = len;
-	resize_memory(len + 1);
-	memcpy(m_buffer + start, sz, len);
-	m_buffer[len] = '\0';
-}
-
-s2::string::string(const s2::string& str)
-	: string(str.m_buffer, 0, str.m_length)
-{
-}
 
-s2::string::~string()
-{
-	if (m_buffer != nullptr) {
-		free(m_buffer);
+	static inline int bitscan_reverse(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, mask);
+		return (int)index;
+#else
+		return 31 - __builtin_clz(mask);
+#endif
 	}
-}
 
-size_t s2::string::len() const
-{
-	return m_length;
-}
+	static const char* memfind_scalar(const char* haystack, size_t len, char c)
+	{
+		return (const char*)memchr(haystack, c, len);
+	}
 
-size_t s2::string::allocsize() const
-{
-	return m_allocSize;
-}
+	static const char* memrfind_scalar(const char* haystack, size_t len, char c)
+	{
+		const char* p = haystack + len;
+		while (p != haystack) {
+			p--;
+			if (*p == c) {
+				return p;
+			}
+		}
+		return nullptr;
+	}
 
-const char* s2::string::c_str() const
-{
-	if (m_buffer == nullptr) {
-		return "";
+	// Candidates for the needle are found by comparing both its first and last character, which filters out most false
+	// positives before we have to compare the whole needle. The SIMD versions below work the same way, but test a
+	// whole block of positions at once.
+	static const char* memfind_scalar(const char* haystack, size_t len, const char* needle, size_t needleLen, size_t start)
+	{
+		const char first = needle[0];
+		const char last = needle[needleLen - 1];
+		for (size_t i = start; i + needleLen <= len; i++) {
+			if (haystack[i] == first && haystack[i + needleLen - 1] == last && !memcmp(haystack + i, needle, needleLen)) {
+				return haystack + i;
+			}
+		}
+		return nullptr;
 	}
-	return m_buffer;
-}
 
-bool s2::string::is_null() const
-{
-	return m_buffer == nullptr;
-}
+	static const char* memrfind_scalar(const char* haystack, const char* needle, size_t needleLen, size_t end)
+	{
+		// Tests all positions below end, starting at the highest position
+		const char first = needle[0];
+		const char last = needle[needleLen - 1];
+		for (size_t i = end; i > 0; i--) {
+			const char* p = haystack + i - 1;
+			if (*p == first && p[needleLen - 1] == last && !memcmp(p, needle, needleLen)) {
+				return p;
+			}
+		}
+		return nullptr;
+	}
 
-int s2::string::indexof(char c) const
-{
-	if (m_buffer == nullptr) {
-		return -1;
+#if defined(S2_STRING_SSE2)
+	static const char* memfind_sse2(const char* haystack, size_t len, char c)
+	{
+		const __m128i vc = _mm_set1_epi8(c);
+		size_t i = 0;
+		for (; i + 16 <= len; i += 16) {
+			__m128i block = _mm_loadu_si128((const __m128i*)(haystack + i));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, vc));
+			if (mask != 0) {
+				return haystack + i + bitscan_forward(mask);
+			}
+		}
+		return memfind_scalar(haystack + i, len - i, c);
 	}
 
-	char* p = m_buffer;
-	while (*p != '\0') {
-		if (*p == c) {
-			return (int)(p - m_buffer);
+	static const char* memrfind_sse2(const char* haystack, size_t len, char c)
+	{
+		const __m128i vc = _mm_set1_epi8(c);
+		size_t i = len;
+		for (; i >= 16; i -= 16) {
+			__m128i block = _mm_loadu_si128((const __m128i*)(haystack + i - 16));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, vc));
+			if (mask != 0) {
+				return haystack + i - 16 + bitscan_reverse(mask);
+			}
 		}
-		p++;
+		return memrfind_scalar(haystack, i, c);
 	}
-	return -1;
-}
 
-int s2::string::indexof(const char* sz) const
-{
-	if (m_buffer == nullptr) {
-		return -1;
+	static const char* memfind_sse2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m128i first = _mm_set1_epi8(needle[0]);
+		const __m128i last = _mm_set1_epi8(needle[needleLen - 1]);
+		size_t i = 0;
+		for (; i + needleLen - 1 + 16 <= len; i += 16) {
+			__m128i blockFirst = _mm_loadu_si128((const __m128i*)(haystack + i));
+			__m128i blockLast = _mm_loadu_si128((const __m128i*)(haystack + i + needleLen - 1));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				const char* p = haystack + i + bitscan_forward(mask);
+				if (!memcmp(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= mask - 1;
+			}
+		}
+		return memfind_scalar(haystack, len, needle, needleLen, i);
 	}
 
-	char* p = strstr(m_buffer, sz);
-	if (p == nullptr) {
-		return -1;
+	static const char* memrfind_sse2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m128i first = _mm_set1_epi8(needle[0]);
+		const __m128i last = _mm_set1_epi8(needle[needleLen - 1]);
+		// Number of remaining positions that can still be tested
+		size_t end = len - needleLen + 1;
+		for (; end >= 16; end -= 16) {
+			size_t i = end - 16;
+			__m128i blockFirst = _mm_loadu_si128((const __m128i*)(haystack + i));
+			__m128i blockLast = _mm_loadu_si128((const __m128i*)(haystack + i + needleLen - 1));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				int bit = bitscan_reverse(mask);
+				const char* p = haystack + i + bit;
+				if (!memcmp(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= ~(1u << bit);
+			}
+		}
+		return memrfind_scalar(haystack, needle, needleLen, end);
 	}
-	return (int)(p - m_buffer);
-}
+#endif
 
-int s2::string::lastindexof(char c) const
-{
-	if (m_buffer == nullptr) {
-		return -1;
+#if defined(S2_STRING_AVX2)
+	static bool cpu_has_avx2()
+	{
+		static const bool supported = []() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			bool osxsave = (info[2] & (1 << 27)) != 0;
+			bool avx = (info[2] & (1 << 28)) != 0;
+			if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+				return false;
+			}
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}();
+		return supported;
 	}
 
-	char* p = m_buffer + m_length;
-	while (p != m_buffer) {
-		p--;
-		if (*p == c) {
-			return (int)(p - m_buffer);
+	S2_TARGET_AVX2 static const char* memfind_avx2(const char* haystack, size_t len, char c)
+	{
+		const __m256i vc = _mm256_set1_epi8(c);
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			__m256i block = _mm256_loadu_si256((const __m256i*)(haystack + i));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, vc));
+			if (mask != 0) {
+				return haystack + i + bitscan_forward(mask);
+			}
 		}
+		return memfind_sse2(haystack + i, len - i, c);
 	}
-	return -1;
-}
 
-int s2::string::lastindexof(const char* sz) const
-{
-	if (m_buffer == nullptr) {
-		return -1;
+	S2_TARGET_AVX2 static const char* memrfind_avx2(const char* haystack, size_t len, char c)
+	{
+		const __m256i vc = _mm256_set1_epi8(c);
+		size_t i = len;
+		for (; i >= 32; i -= 32) {
+			__m256i block = _mm256_loadu_si256((const __m256i*)(haystack + i - 32));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, vc));
+			if (mask != 0) {
+				return haystack + i - 32 + bitscan_reverse(mask);
+			}
+		}
+		return memrfind_sse2(haystack, i, c);
 	}
 
-	char* lp = strstr(m_buffer, sz);
-	char* p = lp;
-	while (p != nullptr) {
-		p = strstr(p + 1, sz);
-		if (p != nullptr) {
-			lp = p;
+	S2_TARGET_AVX2 static const char* memfind_avx2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m256i first = _mm256_set1_epi8(needle[0]);
+		const __m256i last = _mm256_set1_epi8(needle[needleLen - 1]);
+		size_t i = 0;
+		for (; i + needleLen - 1 + 32 <= len; i += 32) {
+			__m256i blockFirst = _mm256_loadu_si256((const __m256i*)(haystack + i));
+			__m256i blockLast = _mm256_loadu_si256((const __m256i*)(haystack + i + needleLen - 1));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				const char* p = haystack + i + bitscan_forward(mask);
+				if (!memcmp(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= mask - 1;
+			}
 		}
+		return memfind_scalar(haystack, len, needle, needleLen, i);
 	}
-	if (lp == nullptr) {
-		return -1;
-	}
-	return (int)(lp - m_buffer);
-}
 
-bool s2::string::contains(const char* sz) const
-{
-	if (m_buffer == nullptr) {
-		return false;
+	S2_TARGET_AVX2 static const char* memrfind_avx2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m256i first = _mm256_set1_epi8(needle[0]);
+		const __m256i last = _mm256_set1_epi8(needle[needleLen - 1]);
+		size_t end = len - needleLen + 1;
+		for (; end >= 32; end -= 32) {
+			size_t i = end - 32;
+			__m256i blockFirst = _mm256_loadu_si256((const __m256i*)(haystack + i));
+			__m256i blockLast = _mm256_loadu_si256((const __m256i*)(haystack + i + needleLen - 1));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				int bit = bitscan_reverse(mask);
+				const char* p = haystack + i + bit;
+				if (!memcmp(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= ~(1u << bit);
+			}
+		}
+		return memrfind_scalar(haystack, needle, needleLen, end);
 	}
-	return strstr(m_buffer, sz) != nullptr;
-}
+#endif
 
-bool s2::string::contains_nocase(const char* sz) const
-{
-	if (m_buffer == nullptr) {
-		return false;
+	static inline char fold_ascii(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
 	}
 
-	size_t matched = 0;
-	for (size_t i = 0; i < m_length; i++) {
-		char c = ::tolower(m_buffer[i]);
-		char ec = ::tolower(sz[matched]);
-		if (ec == '\0') {
-			return true;
-		} else if (c == ec) {
-			if (sz[matched + 1] == '\0') {
-				return true;
+	static bool memeq_nocase(const char* a, const char* b, size_t len)
+	{
+		for (size_t i = 0; i < len; i++) {
+			if (fold_ascii(a[i]) != fold_ascii(b[i])) {
+				return false;
 			}
-			matched++;
-		} else {
-			matched = 0;
 		}
+		return true;
 	}
 
-	return false;
+	static const char* memfind_nocase_scalar(const char* haystack, size_t len, const char* needle, size_t needleLen, size_t start)
+	{
+		const char first = fold_ascii(needle[0]);
+		const char last = fold_ascii(needle[needleLen - 1]);
+		for (size_t i = start; i + needleLen <= len; i++) {
+			const char* p = haystack + i;
+			if (fold_ascii(*p) == first && fold_ascii(p[needleLen - 1]) == last && memeq_nocase(p, needle, needleLen)) {
+				return p;
+			}
+		}
+		return nullptr;
+	}
+
+	static const char* memrfind_nocase_scalar(const char* haystack, const char* needle, size_t needleLen, size_t end)
+	{
+		const char first = fold_ascii(needle[0]);
+		const char last = fold_ascii(needle[needleLen - 1]);
+		for (size_t i = end; i > 0; i--) {
+			const char* p = haystack + i - 1;
+			if (fold_ascii(*p) == first && fold_ascii(p[needleLen - 1]) == last && memeq_nocase(p, needle, needleLen)) {
+				return p;
+			}
+		}
+		return nullptr;
+	}
+
+	// Boyer-Moore-Horspool, which skips ahead by up to the length of the needle on every mismatch. This beats testing
+	// every position when the needle is long.
+	static const char* memfind_nocase_horspool(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		size_t shift[256];
+		for (size_t i = 0; i < 256; i++) {
+			shift[i] = needleLen;
+		}
+		for (size_t i = 0; i < needleLen - 1; i++) {
+			shift[(uint8_t)fold_ascii(needle[i])] = needleLen - 1 - i;
+		}
+
+		const char last = fold_ascii(needle[needleLen - 1]);
+		for (size_t i = 0; i + needleLen <= len;) {
+			char c = fold_ascii(haystack[i + needleLen - 1]);
+			if (c == last && memeq_nocase(haystack + i, needle, needleLen - 1)) {
+				return haystack + i;
+			}
+			i += shift[(uint8_t)c];
+		}
+		return nullptr;
+	}
+
+	// The same as above, but mirrored: we align the needle at the end and test its first character
+	static const char* memrfind_nocase_horspool(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		size_t shift[256];
+		for (size_t i = 0; i < 256; i++) {
+			shift[i] = needleLen;
+		}
+		for (size_t i = needleLen - 1; i > 0; i--) {
+			shift[(uint8_t)fold_ascii(needle[i])] = i;
+		}
+
+		const char first = fold_ascii(needle[0]);
+		size_t end = len - needleLen + 1;
+		while (end > 0) {
+			const char* p = haystack + end - 1;
+			char c = fold_ascii(*p);
+			if (c == first && memeq_nocase(p + 1, needle + 1, needleLen - 1)) {
+				return p;
+			}
+			size_t skip = shift[(uint8_t)c];
+			if (skip >= end) {
+				break;
+			}
+			end -= skip;
+		}
+		return nullptr;
+	}
+
+#if defined(S2_STRING_SSE2)
+	// Lowercases all ASCII letters in the block. Adding 63 maps 'A'..'Z' onto the lowest signed values (-128..-103),
+	// which lets us test the range with a single signed compare.
+	static inline __m128i fold_ascii_sse2(__m128i block)
+	{
+		__m128i shifted = _mm_add_epi8(block, _mm_set1_epi8(128 - 'A'));
+		__m128i upper = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+		return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+	}
+
+	static const char* memfind_nocase_sse2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m128i first = _mm_set1_epi8(fold_ascii(needle[0]));
+		const __m128i last = _mm_set1_epi8(fold_ascii(needle[needleLen - 1]));
+		size_t i = 0;
+		for (; i + needleLen - 1 + 16 <= len; i += 16) {
+			__m128i blockFirst = fold_ascii_sse2(_mm_loadu_si128((const __m128i*)(haystack + i)));
+			__m128i blockLast = fold_ascii_sse2(_mm_loadu_si128((const __m128i*)(haystack + i + needleLen - 1)));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				const char* p = haystack + i + bitscan_forward(mask);
+				if (needleLen < 2 || memeq_nocase(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= mask - 1;
+			}
+		}
+		return memfind_nocase_scalar(haystack, len, needle, needleLen, i);
+	}
+
+	static const char* memrfind_nocase_sse2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m128i first = _mm_set1_epi8(fold_ascii(needle[0]));
+		const __m128i last = _mm_set1_epi8(fold_ascii(needle[needleLen - 1]));
+		size_t end = len - needleLen + 1;
+		for (; end >= 16; end -= 16) {
+			size_t i = end - 16;
+			__m128i blockFirst = fold_ascii_sse2(_mm_loadu_si128((const __m128i*)(haystack + i)));
+			__m128i blockLast = fold_ascii_sse2(_mm_loadu_si128((const __m128i*)(haystack + i + needleLen - 1)));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				int bit = bitscan_reverse(mask);
+				const char* p = haystack + i + bit;
+				if (needleLen < 2 || memeq_nocase(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= ~(1u << bit);
+			}
+		}
+		return memrfind_nocase_scalar(haystack, needle, needleLen, end);
+	}
+#endif
+
+#if defined(S2_STRING_AVX2)
+	S2_TARGET_AVX2 static inline __m256i fold_ascii_avx2(__m256i block)
+	{
+		__m256i shifted = _mm256_add_epi8(block, _mm256_set1_epi8(128 - 'A'));
+		__m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+		return _mm256_or_si256(block, _mm256_and_si256(upper, _mm256_set1_epi8('a' - 'A')));
+	}
+
+	S2_TARGET_AVX2 static const char* memfind_nocase_avx2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m256i first = _mm256_set1_epi8(fold_ascii(needle[0]));
+		const __m256i last = _mm256_set1_epi8(fold_ascii(needle[needleLen - 1]));
+		size_t i = 0;
+		for (; i + needleLen - 1 + 32 <= len; i += 32) {
+			__m256i blockFirst = fold_ascii_avx2(_mm256_loadu_si256((const __m256i*)(haystack + i)));
+			__m256i blockLast = fold_ascii_avx2(_mm256_loadu_si256((const __m256i*)(haystack + i + needleLen - 1)));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				const char* p = haystack + i + bitscan_forward(mask);
+				if (needleLen < 2 || memeq_nocase(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= mask - 1;
+			}
+		}
+		return memfind_nocase_scalar(haystack, len, needle, needleLen, i);
+	}
+
+	S2_TARGET_AVX2 static const char* memrfind_nocase_avx2(const char* haystack, size_t len, const char* needle, size_t needleLen)
+	{
+		const __m256i first = _mm256_set1_epi8(fold_ascii(needle[0]));
+		const __m256i last = _mm256_set1_epi8(fold_ascii(needle[needleLen - 1]));
+		size_t end = len - needleLen + 1;
+		for (; end >= 32; end -= 32) {
+			size_t i = end - 32;
+			__m256i blockFirst = fold_ascii_avx2(_mm256_loadu_si256((const __m256i*)(haystack + i)));
+			__m256i blockLast = fold_ascii_avx2(_mm256_loadu_si256((const __m256i*)(haystack + i + needleLen - 1)));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first), _mm256_cmpeq_epi8(blockLast, last)));
+			while (mask != 0) {
+				int bit = bitscan_reverse(mask);
+				const char* p = haystack + i + bit;
+				if (needleLen < 2 || memeq_nocase(p + 1, needle + 1, needleLen - 2)) {
+					return p;
+				}
+				mask &= ~(1u << bit);
+			}
+		}
+		return memrfind_nocase_scalar(haystack, needle, needleLen, end);
+	}
+#endif
+
+	static inline char unfold_ascii(char c)
+	{
+		return (c >= 'a' && c <= 'z') ? (char)(c - ('a' - 'A')) : c;
+	}
+
+	static void memlower_scalar(char* dst, const char* src, size_t len)
+	{
+		for (size_t i = 0; i < len; i++) {
+			dst[i] = fold_ascii(src[i]);
+		}
+	}
+
+	static void memupper_scalar(char* dst, const char* src, size_t len)
+	{
+		for (size_t i = 0; i < len; i++) {
+			dst[i] = unfold_ascii(src[i]);
+		}
+	}
+
+#if defined(S2_STRING_SSE2)
+	// Uppercases all ASCII letters in the block, using the same range test as fold_ascii_sse2
+	static inline __m128i unfold_ascii_sse2(__m128i block)
+	{
+		__m128i shifted = _mm_add_epi8(block, _mm_set1_epi8(128 - 'a'));
+		__m128i lower = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+		return _mm_andnot_si128(_mm_and_si128(lower, _mm_set1_epi8('a' - 'A')), block);
+	}
+
+	static void memlower_sse2(char* dst, const char* src, size_t len)
+	{
+		size_t i = 0;
+		for (; i + 16 <= len; i += 16) {
+			_mm_storeu_si128((__m128i*)(dst + i), fold_ascii_sse2(_mm_loadu_si128((const __m128i*)(src + i))));
+		}
+		memlower_scalar(dst + i, src + i, len - i);
+	}
+
+	static void memupper_sse2(char* dst, const char* src, size_t len)
+	{
+		size_t i = 0;
+		for (; i + 16 <= len; i += 16) {
+			_mm_storeu_si128((__m128i*)(dst + i), unfold_ascii_sse2(_mm_loadu_si128((const __m128i*)(src + i))));
+		}
+		memupper_scalar(dst + i, src + i, len - i);
+	}
+#endif
+
+#if defined(S2_STRING_AVX2)
+	S2_TARGET_AVX2 static inline __m256i unfold_ascii_avx2(__m256i block)
+	{
+		__m256i shifted = _mm256_add_epi8(block, _mm256_set1_epi8(128 - 'a'));
+		__m256i lower = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+		return _mm256_andnot_si256(_mm256_and_si256(lower, _mm256_set1_epi8('a' - 'A')), block);
+	}
+
+	S2_TARGET_AVX2 static void memlower_avx2(char* dst, const char* src, size_t len)
+	{
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			_mm256_storeu_si256((__m256i*)(dst + i), fold_ascii_avx2(_mm256_loadu_si256((const __m256i*)(src + i))));
+		}
+		memlower_scalar(dst + i, src + i, len - i);
+	}
+
+	S2_TARGET_AVX2 static void memupper_avx2(char* dst, const char* src, size_t len)
+	{
+		size_t i = 0;
+		for (; i + 32 <= len; i += 32) {
+			_mm256_storeu_si256((__m256i*)(dst + i), unfold_ascii_avx2(_mm256_loadu_si256((const __m256i*)(src + i))));
+		}
+		memupper_scalar(dst + i, src + i, len - i);
+	}
+#endif
+}
+
+const char* s2::memfind(const char* haystack, size_t len, char c)
+{
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return memfind_avx2(haystack, len, c);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return memfind_sse2(haystack, len, c);
+#else
+	return memfind_scalar(haystack, len, c);
+#endif
+}
+
+const char* s2::memrfind(const char* haystack, size_t len, char c)
+{
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return memrfind_avx2(haystack, len, c);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return memrfind_sse2(haystack, len, c);
+#else
+	return memrfind_scalar(haystack, len, c);
+#endif
+}
+
+const char* s2::memfind(const char* haystack, size_t len, const char* needle, size_t needleLen)
+{
+	if (needleLen == 0) {
+		return haystack;
+	} else if (needleLen > len) {
+		return nullptr;
+	} else if (needleLen == 1) {
+		return memfind(haystack, len, needle[0]);
+	}
+
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return memfind_avx2(haystack, len, needle, needleLen);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return memfind_sse2(haystack, len, needle, needleLen);
+#else
+	return memfind_scalar(haystack, len, needle, needleLen, 0);
+#endif
+}
+
+const char* s2::memrfind(const char* haystack, size_t len, const char* needle, size_t needleLen)
+{
+	if (needleLen == 0) {
+		return haystack + len;
+	} else if (needleLen > len) {
+		return nullptr;
+	} else if (needleLen == 1) {
+		return memrfind(haystack, len, needle[0]);
+	}
+
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return memrfind_avx2(haystack, len, needle, needleLen);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return memrfind_sse2(haystack, len, needle, needleLen);
+#else
+	return memrfind_scalar(haystack, needle, needleLen, len - needleLen + 1);
+#endif
+}
+
+const char* s2::memfind_nocase(const char* haystack, size_t len, const char* needle, size_t needleLen)
+{
+	if (needleLen == 0) {
+		return haystack;
+	} else if (needleLen > len) {
+		return nullptr;
+	} else if (needleLen >= nocase_horspool_min_length) {
+		return memfind_nocase_horspool(haystack, len, needle, needleLen);
+	}
+
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return memfind_nocase_avx2(haystack, len, needle, needleLen);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return memfind_nocase_sse2(haystack, len, needle, needleLen);
+#else
+	return memfind_nocase_scalar(haystack, len, needle, needleLen, 0);
+#endif
+}
+
+const char* s2::memrfind_nocase(const char* haystack, size_t len, const char* needle, size_t needleLen)
+{
+	if (needleLen == 0) {
+		return haystack + len;
+	} else if (needleLen > len) {
+		return nullptr;
+	} else if (needleLen >= nocase_horspool_min_length) {
+		return memrfind_nocase_horspool(haystack, len, needle, needleLen);
+	}
+
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return memrfind_nocase_avx2(haystack, len, needle, needleLen);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return memrfind_nocase_sse2(haystack, len, needle, needleLen);
+#else
+	return memrfind_nocase_scalar(haystack, needle, needleLen, len - needleLen + 1);
+#endif
+}
+
+void s2::memlower(char* dst, const char* src, size_t len)
+{
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		memlower_avx2(dst, src, len);
+		return;
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	memlower_sse2(dst, src, len);
+#else
+	memlower_scalar(dst, src, len);
+#endif
+}
+
+void s2::memupper(char* dst, const char* src, size_t len)
+{
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		memupper_avx2(dst, src, len);
+		return;
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	memupper_sse2(dst, src, len);
+#else
+	memupper_scalar(dst, src, len);
+#endif
+}
+
+s2::string::string()
+{
+	m_heap = nullptr;
+	m_length = 0;
+	m_allocSize = 0;
+}
+
+s2::string::string(const char* sz)
+	: string(sz, 0, sz != nullptr ? strlen(sz) : 0)
+{
+}
+
+s2::string::string(const char* sz, size_t len)
+	: string(sz, 0, len)
+{
+}
+
+s2::string::string(const char* sz, size_t start, size_t len)
+	: string()
+{
+	if (sz == nullptr) {
+		return;
+	}
+	m_length = len;
+	resize_memory(len + 1);
+	memcpy(buffer() + start, sz, len);
+	buffer()[len] = '\0';
+}
+
+s2::string::string(const s2::string& str)
+	: string(str.buffer(), 0, str.m_length)
+{
+}
+
+s2::string::string(s2::string&& str)
+{
+	take_memory(str);
+}
+
+s2::string::~string()
+{
+	if (!is_local()) {
+		S2_FREE(m_heap);
+	}
+}
+
+size_t s2::string::len() const
+{
+	return m_length;
+}
+
+size_t s2::string::allocsize() const
+{
+	return m_allocSize;
+}
+
+const char* s2::string::c_str() const
+{
+	if (is_null()) {
+		return "";
+	}
+	return buffer();
+}
+
+bool s2::string::is_null() const
+{
+	return m_allocSize == 0;
+}
+
+int s2::string::indexof(char c) const
+{
+	if (is_null()) {
+		return -1;
+	}
+
+	const char* p = memfind(buffer(), m_length, c);
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - buffer());
+}
+
+int s2::string::indexof(const char* sz) const
+{
+	if (is_null()) {
+		return -1;
+	}
+
+	const char* p = memfind(buffer(), m_length, sz, strlen(sz));
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - buffer());
+}
+
+int s2::string::lastindexof(char c) const
+{
+	if (is_null()) {
+		return -1;
+	}
+
+	const char* p = memrfind(buffer(), m_length, c);
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - buffer());
+}
+
+int s2::string::lastindexof(const char* sz) const
+{
+	if (is_null()) {
+		return -1;
+	}
+
+	const char* p = memrfind(buffer(), m_length, sz, strlen(sz));
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - buffer());
+}
+
+bool s2::string::contains(const char* sz) const
+{
+	if (is_null()) {
+		return false;
+	}
+	return memfind(buffer(), m_length, sz, strlen(sz)) != nullptr;
+}
+
+int s2::string::indexof_nocase(const char* sz) const
+{
+	if (is_null()) {
+		return -1;
+	}
+
+	const char* p = memfind_nocase(buffer(), m_length, sz, strlen(sz));
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - buffer());
+}
+
+int s2::string::lastindexof_nocase(const char* sz) const
+{
+	if (is_null()) {
+		return -1;
+	}
+
+	const char* p = memrfind_nocase(buffer(), m_length, sz, strlen(sz));
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - buffer());
+}
+
+bool s2::string::contains_nocase(const char* sz) const
+{
+	if (is_null()) {
+		return false;
+	}
+	return memfind_nocase(buffer(), m_length, sz, strlen(sz)) != nullptr;
+}
+
+bool s2::string::startswith(const char* sz) const
+{
+	if (is_null()) {
+		return false;
+	}
+	size_t len = strlen(sz);
+	return len <= m_length && !memcmp(buffer(), sz, len);
+}
+
+bool s2::string::endswith(const char* sz) const
+{
+	if (is_null()) {
+		return false;
+	}
+	size_t len = strlen(sz);
+	return len <= m_length && !memcmp(buffer() + m_length - len, sz, len);
+}
+
+s2::stringsplit s2::string::split(const char* delim, int limit) const
+{
+	return stringsplit(buffer(), delim, limit);
+}
+
+s2::stringsplit s2::string::commandlinesplit() const
+{
+	return stringsplit(buffer(), true);
+}
+
+s2::splitview s2::string::split_view(const char* delim, int limit) const
+{
+	return splitview(buffer(), m_length, delim, limit);
+}
+
+s2::splitview s2::string::split_view(const s2::charset& delims, int limit) const
+{
+	return splitview(buffer(), m_length, delims, limit);
+}
+
+s2::string s2::string::substr(intptr_t start) const
+{
+	if (m_length == 0 || is_null()) {
+		return "";
+	}
+	while (start < 0) {
+		start += (intptr_t)m_length;
+	}
+	if ((size_t)start >= m_length) {
+		return "";
+	}
+	return string(buffer() + start);
+}
+
+s2::string s2::string::substr(intptr_t start, intptr_t len) const
+{
+	if (m_length == 0 || is_null()) {
+		return "";
+	}
+	while (start < 0) {
+		start += (intptr_t)m_length;
+	}
+	if ((size_t)start >= m_length) {
+		return "";
+	}
+	intptr_t remainder = (intptr_t)strlen(buffer()) + start;
+	if (len > remainder) {
+		len = remainder;
+	}
+	return string(buffer() + start, len);
+}
+
+void s2::string::append(char c)
+{
+	append(&c, 0, 1);
+}
+
+void s2::string::append(const char* sz)
+{
+	if (sz == nullptr) {
+		return;
+	}
+	append(sz, 0, strlen(sz));
+}
+
+void s2::string::append(const char* sz, size_t len)
+{
+	if (sz == nullptr) {
+		return;
+	}
+	append(sz, 0, len);
+}
+
+void s2::string::append(const char* sz, size_t start, size_t len)
+{
+	if (sz == nullptr) {
+		return;
+	}
+	ensure_memory(m_length + len + 1);
+	memcpy(buffer() + m_length, sz + start, len);
+	m_length += len;
+	buffer()[m_length] = '\0';
+}
+
+void s2::string::append(const s2::string& str)
+{
+	append(str.buffer(), 0, str.m_length);
+}
+
+void s2::string::append(s2::string&& str)
+{
+	if (m_length == 0) {
+		// There's nothing to keep in our own buffer, so we can just take the other buffer
+		*this = static_cast<string&&>(str);
+		return;
+	}
+	append(str.buffer(), 0, str.m_length);
+}
+
+void s2::string::insert(const char* sz, size_t pos)
+{
+	insert(sz, pos, strlen(sz));
+}
+
+void s2::string::insert(const char* sz, size_t pos, size_t len)
+{
+	ensure_memory(m_length + len + 1);
+	memmove(buffer() + pos + len, buffer() + pos, m_length - pos);
+	memcpy(buffer() + pos, sz, len);
+	m_length += len;
+	buffer()[m_length] = '\0';
+}
+
+void s2::string::remove(size_t pos, size_t len)
+{
+	if (is_null()) {
+		return;
+	}
+	memmove(buffer() + pos, buffer() + pos + len, m_length - pos - len);
+	m_length -= len;
+	buffer()[m_length] = '\0';
+}
+
+s2::string s2::string::replace(char find, char replace) const
+{
+	if (is_null()) {
+		return *this;
+	}
+
+	s2::string ret(*this);
+	char* p = ret.buffer();
+	while (*p != '\0') {
+		if (*p == find) {
+			*p = replace;
+		}
+		p++;
+	}
+	return ret;
+}
+
+s2::string s2::string::replace(const char* find, const char* replace) const
+{
+	if (is_null() || find == nullptr || replace == nullptr) {
+		return *this;
+	}
+
+	replacepair pair = { find, replace };
+	return replace_all(&pair, 1);
+}
+
+s2::string s2::string::replace(const char* findchars, char replace) const
+{
+	if (is_null() || findchars == nullptr) {
+		return *this;
+	}
+	return this->replace(charset(findchars), replace);
+}
+
+s2::string s2::string::replace(const s2::charset& findchars, char replace) const
+{
+	if (is_null() || findchars.is_empty()) {
+		return *this;
+	}
+
+	s2::string ret(*this);
+	char* p = ret.buffer();
+	while (*p != '\0') {
+		if (findchars.contains(*p)) {
+			*p = replace;
+		}
+		p++;
+	}
+	return ret;
+}
+
+s2::string s2::string::replace_all(std::initializer_list<replacepair> pairs) const
+{
+	return replace_all(pairs.begin(), pairs.size());
+}
+
+s2::string s2::string::replace_all(const replacepair* pairs, size_t count) const
+{
+	if (is_null() || count == 0) {
+		return *this;
+	}
+
+	struct findstate
+	{
+		size_t findLen;
+		size_t replaceLen;
+		const char* next;
+	};
+
+	findstate localStates[8];
+	findstate* states = localStates;
+	if (count > sizeof(localStates) / sizeof(findstate)) {
+		states = (findstate*)S2_MALLOC(count * sizeof(findstate));
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		auto& state = states[i];
+		state.findLen = pairs[i].find != nullptr ? strlen(pairs[i].find) : 0;
+		state.replaceLen = pairs[i].replace != nullptr ? strlen(pairs[i].replace) : 0;
+	}
+
+	const char* start = buffer();
+	const char* end = start + m_length;
+
+	// Walks over all matches and returns the length of the output. If out is not null, the output is also written to it.
+	// Each state keeps the position of its next match, so every find string only scans forward through the buffer once.
+	auto scan = [&](char* out) {
+		for (size_t i = 0; i < count; i++) {
+			auto& state = states[i];
+			state.next = state.findLen > 0 ? memfind(start, m_length, pairs[i].find, state.findLen) : nullptr;
+		}
+
+		const char* p = start;
+		size_t outLen = 0;
+		while (true) {
+			size_t best = count;
+			for (size_t i = 0; i < count; i++) {
+				if (states[i].next != nullptr && (best == count || states[i].next < states[best].next)) {
+					best = i;
+				}
+			}
+			if (best == count) {
+				break;
+			}
+
+			auto& match = states[best];
+			size_t segmentLen = match.next - p;
+			if (out != nullptr) {
+				memcpy(out + outLen, p, segmentLen);
+				memcpy(out + outLen + segmentLen, pairs[best].replace, match.replaceLen);
+			}
+			outLen += segmentLen + match.replaceLen;
+			p = match.next + match.findLen;
+
+			// Find strings whose next match overlaps with what we just replaced have to look further ahead
+			for (size_t i = 0; i < count; i++) {
+				auto& state = states[i];
+				if (state.next != nullptr && state.next < p) {
+					state.next = memfind(p, end - p, pairs[i].find, state.findLen);
+				}
+			}
+		}
+
+		if (out != nullptr) {
+			memcpy(out + outLen, p, end - p);
+		}
+		return outLen + (end - p);
+	};
+
+	s2::string ret;
+	size_t len = scan(nullptr);
+	ret.ensure_memory(len + 1);
+	scan(ret.buffer());
+	ret.m_length = len;
+	ret.buffer()[len] = '\0';
+
+	if (states != localStates) {
+		S2_FREE(states);
+	}
+	return ret;
+}
+
+void s2::string::setf(const char* format, ...)
+{
+	ensure_memory(min_buffer_size);
+
+	va_list vl;
+	va_start(vl, format);
+	int len = vsnprintf(buffer(), m_allocSize, format, vl);
+	va_end(vl);
+
+	if (len >= min_buffer_size) {
+		ensure_memory(len + 1);
+
+		va_list vl;
+		va_start(vl, format);
+		vsnprintf(buffer(), m_allocSize, format, vl);
+		va_end(vl);
+	}
+
+	m_length = len;
+}
+
+namespace s2
+{
+	static const char two_digit_table[] =
+		"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+
+	static inline size_t count_digits(uint64_t value)
+	{
+		size_t ret = 1;
+		while (value >= 10000) {
+			value /= 10000;
+			ret += 4;
+		}
+		if (value >= 1000) {
+			return ret + 3;
+		}
+		if (value >= 100) {
+			return ret + 2;
+		}
+		if (value >= 10) {
+			return ret + 1;
+		}
+		return ret;
+	}
+
+	// Writes the digits of value backwards, ending right before the given pointer, two digits at a time
+	static inline void write_digits_backwards(char* end, uint64_t value)
+	{
+		while (value >= 100) {
+			const char* pair = two_digit_table + (value % 100) * 2;
+			value /= 100;
+			*--end = pair[1];
+			*--end = pair[0];
+		}
+		if (value >= 10) {
+			const char* pair = two_digit_table + value * 2;
+			*--end = pair[1];
+			*--end = pair[0];
+		} else {
+			*--end = '0' + (char)value;
+		}
+	}
+
+	static inline size_t count_hex_digits(uint64_t value)
+	{
+		size_t ret = 1;
+		while (value >= 16) {
+			value >>= 4;
+			ret++;
+		}
+		return ret;
+	}
+
+	static inline void write_hex_backwards(char* end, uint64_t value, bool uppercase)
+	{
+		const char* digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+		do {
+			*--end = digits[value & 0xF];
+			value >>= 4;
+		} while (value != 0);
+	}
+
+	// The shortest round-trip double formatting below is the Grisu2 algorithm by Florian Loitsch, from "Printing
+	// Floating-Point Numbers Quickly and Accurately with Integers". It finds the shortest digits within the rounding
+	// boundaries of the double in almost all cases, and the result always parses back to the exact same value.
+	struct diyfp
+	{
+		uint64_t f;
+		int e;
+	};
+
+	static inline diyfp diyfp_mul(const diyfp& x, const diyfp& y)
+	{
+		// Multiplies the 64-bit significands into a 128-bit result and keeps the upper half, rounded
+		uint64_t u_lo = x.f & 0xFFFFFFFFu;
+		uint64_t u_hi = x.f >> 32;
+		uint64_t v_lo = y.f & 0xFFFFFFFFu;
+		uint64_t v_hi = y.f >> 32;
+
+		uint64_t p0 = u_lo * v_lo;
+		uint64_t p1 = u_lo * v_hi;
+		uint64_t p2 = u_hi * v_lo;
+		uint64_t p3 = u_hi * v_hi;
+
+		uint64_t q = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+		q += 1llu << 31;
+
+		return { p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32), x.e + y.e + 64 };
+	}
+
+	static inline diyfp diyfp_normalize(diyfp x)
+	{
+		while ((x.f >> 63) == 0) {
+			x.f <<= 1;
+			x.e--;
+		}
+		return x;
+	}
+
+	struct cachedpower
+	{
+		uint64_t f;
+		int e;
+		int k;
+	};
+
+	// Normalized significands of 10^k for k = -300, -292, ..., 324
+	static const cachedpower cached_powers_of_ten[] = {
+		{ 0xAB70FE17C79AC6CAllu, -1060, -300 }, { 0xFF77B1FCBEBCDC4Fllu, -1034, -292 },
+		{ 0xBE5691EF416BD60Cllu, -1007, -284 }, { 0x8DD01FAD907FFC3Cllu, -980, -276 },
+		{ 0xD3515C2831559A83llu, -954, -268 }, { 0x9D71AC8FADA6C9B5llu, -927, -260 },
+		{ 0xEA9C227723EE8BCBllu, -901, -252 }, { 0xAECC49914078536Dllu, -874, -244 },
+		{ 0x823C12795DB6CE57llu, -847, -236 }, { 0xC21094364DFB5637llu, -821, -228 },
+		{ 0x9096EA6F3848984Fllu, -794, -220 }, { 0xD77485CB25823AC7llu, -768, -212 },
+		{ 0xA086CFCD97BF97F4llu, -741, -204 }, { 0xEF340A98172AACE5llu, -715, -196 },
+		{ 0xB23867FB2A35B28Ellu, -688, -188 }, { 0x84C8D4DFD2C63F3Bllu, -661, -180 },
+		{ 0xC5DD44271AD3CDBAllu, -635, -172 }, { 0x936B9FCEBB25C996llu, -608, -164 },
+		{ 0xDBAC6C247D62A584llu, -582, -156 }, { 0xA3AB66580D5FDAF6llu, -555, -148 },
+		{ 0xF3E2F893DEC3F126llu, -529, -140 }, { 0xB5B5ADA8AAFF80B8llu, -502, -132 },
+		{ 0x87625F056C7C4A8Bllu, -475, -124 }, { 0xC9BCFF6034C13053llu, -449, -116 },
+		{ 0x964E858C91BA2655llu, -422, -108 }, { 0xDFF9772470297EBDllu, -396, -100 },
+		{ 0xA6DFBD9FB8E5B88Fllu, -369, -92 }, { 0xF8A95FCF88747D94llu, -343, -84 },
+		{ 0xB94470938FA89BCFllu, -316, -76 }, { 0x8A08F0F8BF0F156Bllu, -289, -68 },
+		{ 0xCDB02555653131B6llu, -263, -60 }, { 0x993FE2C6D07B7FACllu, -236, -52 },
+		{ 0xE45C10C42A2B3B06llu, -210, -44 }, { 0xAA242499697392D3llu, -183, -36 },
+		{ 0xFD87B5F28300CA0Ellu, -157, -28 }, { 0xBCE5086492111AEBllu, -130, -20 },
+		{ 0x8CBCCC096F5088CCllu, -103, -12 }, { 0xD1B71758E219652Cllu, -77, -4 },
+		{ 0x9C40000000000000llu, -50, 4 }, { 0xE8D4A51000000000llu, -24, 12 },
+		{ 0xAD78EBC5AC620000llu, 3, 20 }, { 0x813F3978F8940984llu, 30, 28 },
+		{ 0xC097CE7BC90715B3llu, 56, 36 }, { 0x8F7E32CE7BEA5C70llu, 83, 44 },
+		{ 0xD5D238A4ABE98068llu, 109, 52 }, { 0x9F4F2726179A2245llu, 136, 60 },
+		{ 0xED63A231D4C4FB27llu, 162, 68 }, { 0xB0DE65388CC8ADA8llu, 189, 76 },
+		{ 0x83C7088E1AAB65DBllu, 216, 84 }, { 0xC45D1DF942711D9Allu, 242, 92 },
+		{ 0x924D692CA61BE758llu, 269, 100 }, { 0xDA01EE641A708DEAllu, 295, 108 },
+		{ 0xA26DA3999AEF774Allu, 322, 116 }, { 0xF209787BB47D6B85llu, 348, 124 },
+		{ 0xB454E4A179DD1877llu, 375, 132 }, { 0x865B86925B9BC5C2llu, 402, 140 },
+		{ 0xC83553C5C8965D3Dllu, 428, 148 }, { 0x952AB45CFA97A0B3llu, 455, 156 },
+		{ 0xDE469FBD99A05FE3llu, 481, 164 }, { 0xA59BC234DB398C25llu, 508, 172 },
+		{ 0xF6C69A72A3989F5Cllu, 534, 180 }, { 0xB7DCBF5354E9BECEllu, 561, 188 },
+		{ 0x88FCF317F22241E2llu, 588, 196 }, { 0xCC20CE9BD35C78A5llu, 614, 204 },
+		{ 0x98165AF37B2153DFllu, 641, 212 }, { 0xE2A0B5DC971F303Allu, 667, 220 },
+		{ 0xA8D9D1535CE3B396llu, 694, 228 }, { 0xFB9B7CD9A4A7443Cllu, 720, 236 },
+		{ 0xBB764C4CA7A44410llu, 747, 244 }, { 0x8BAB8EEFB6409C1Allu, 774, 252 },
+		{ 0xD01FEF10A657842Cllu, 800, 260 }, { 0x9B10A4E5E9913129llu, 827, 268 },
+		{ 0xE7109BFBA19C0C9Dllu, 853, 276 }, { 0xAC2820D9623BF429llu, 880, 284 },
+		{ 0x80444B5E7AA7CF85llu, 907, 292 }, { 0xBF21E44003ACDD2Dllu, 933, 300 },
+		{ 0x8E679C2F5E44FF8Fllu, 960, 308 }, { 0xD433179D9C8CB841llu, 986, 316 },
+		{ 0x9E19DB92B4E31BA9llu, 1013, 324 },
+	};
+
+	static const int grisu_alpha = -60;
+	static const int grisu_gamma = -32;
+
+	// Finds a cached power of ten c so that the exponent of w * c ends up in the range [alpha, gamma]
+	static inline cachedpower cached_power_for_exponent(int e)
+	{
+		int f = grisu_alpha - e - 1;
+		int k = (f * 78913) / (1 << 18) + (f > 0);
+		int index = (300 + k + 7) / 8;
+		return cached_powers_of_ten[index];
+	}
+
+	static inline void grisu2_round(char* buffer, int len, uint64_t dist, uint64_t delta, uint64_t rest, uint64_t tenK)
+	{
+		// Move the last digit down for as long as that brings the number closer to the exact value
+		while (rest < dist && delta - rest >= tenK && (rest + tenK < dist || dist - rest > rest + tenK - dist)) {
+			buffer[len - 1]--;
+			rest += tenK;
+		}
+	}
+
+	static void grisu2_digits(char* buffer, int& len, int& exponent, diyfp minus, diyfp w, diyfp plus)
+	{
+		uint64_t delta = plus.f - minus.f;
+		uint64_t dist = plus.f - w.f;
+
+		int shift = -plus.e;
+		uint64_t one = 1llu << shift;
+
+		uint32_t p1 = (uint32_t)(plus.f >> shift);
+		uint64_t p2 = plus.f & (one - 1);
+
+		// Generate the digits of the integral part
+		uint32_t pow10 = 1;
+		int n = 1;
+		while (n < 10 && p1 >= pow10 * 10) {
+			pow10 *= 10;
+			n++;
+		}
+
+		while (n > 0) {
+			uint32_t digit = p1 / pow10;
+			p1 %= pow10;
+			buffer[len++] = '0' + (char)digit;
+			n--;
+
+			uint64_t rest = ((uint64_t)p1 << shift) + p2;
+			if (rest <= delta) {
+				exponent += n;
+				grisu2_round(buffer, len, dist, delta, rest, (uint64_t)pow10 << shift);
+				return;
+			}
+			pow10 /= 10;
+		}
+
+		// Generate the digits of the fractional part
+		int m = 0;
+		for (;;) {
+			p2 *= 10;
+			buffer[len++] = '0' + (char)(p2 >> shift);
+			p2 &= one - 1;
+			m++;
+
+			delta *= 10;
+			dist *= 10;
+			if (p2 <= delta) {
+				break;
+			}
+		}
+
+		exponent -= m;
+		grisu2_round(buffer, len, dist, delta, p2, one);
+	}
+
+	// Generates the shortest digits for a positive finite value v.f * 2^v.e, so that value = digits * 10^exponent. The
+	// boundaries are halfway to the neighbouring values of the floating point type, where the lower one is closer at
+	// powers of two.
+	static void grisu2(char* buffer, int& len, int& exponent, diyfp v, bool lowerCloser)
+	{
+		diyfp plus = diyfp_normalize({ v.f * 2 + 1, v.e - 1 });
+		diyfp minus = lowerCloser ? diyfp{ v.f * 4 - 1, v.e - 2 } : diyfp{ v.f * 2 - 1, v.e - 1 };
+		minus.f <<= minus.e - plus.e;
+		minus.e = plus.e;
+		v = diyfp_normalize(v);
+
+		cachedpower cached = cached_power_for_exponent(plus.e);
+		diyfp c = { cached.f, cached.e };
+
+		diyfp w = diyfp_mul(v, c);
+		diyfp wMinus = diyfp_mul(minus, c);
+		diyfp wPlus = diyfp_mul(plus, c);
+
+		// Stay on the safe side of the boundaries, which are only known within 1 ulp
+		wMinus.f++;
+		wPlus.f--;
+
+		len = 0;
+		exponent = -cached.k;
+		grisu2_digits(buffer, len, exponent, wMinus, w, wPlus);
+	}
+
+	static void grisu2(char* buffer, int& len, int& exponent, double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint64_t fraction = bits & ((1llu << 52) - 1);
+		int biasedExponent = (int)(bits >> 52);
+
+		if (biasedExponent == 0) {
+			grisu2(buffer, len, exponent, { fraction, 1 - 1075 }, false);
+		} else {
+			grisu2(buffer, len, exponent, { fraction + (1llu << 52), biasedExponent - 1075 }, fraction == 0 && biasedExponent > 1);
+		}
+	}
+
+	static void grisu2(char* buffer, int& len, int& exponent, float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t fraction = bits & ((1u << 23) - 1);
+		int biasedExponent = (int)(bits >> 23);
+
+		if (biasedExponent == 0) {
+			grisu2(buffer, len, exponent, { fraction, 1 - 150 }, false);
+		} else {
+			grisu2(buffer, len, exponent, { fraction + (1u << 23), biasedExponent - 150 }, fraction == 0 && biasedExponent > 1);
+		}
+	}
+
+	static inline bool sign_bit(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return (bits >> 63) != 0;
+	}
+
+	static inline bool sign_bit(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return (bits >> 31) != 0;
+	}
+
+	// Writes the sign and the shortest digits of a float or a double, in the notation described at format_double
+	template<typename T>
+	static size_t format_shortest(char* buffer, T value, T maxValue)
+	{
+		char* p = buffer;
+
+		if (sign_bit(value)) {
+			*p++ = '-';
+			value = -value;
+		}
+
+		if (value != value) {
+			memcpy(buffer, "nan", 3);
+			return 3;
+		}
+		if (value > maxValue) {
+			memcpy(p, "inf", 3);
+			return p + 3 - buffer;
+		}
+		if (value == 0) {
+			*p = '0';
+			return p + 1 - buffer;
+		}
+
+		char digits[18];
+		int len, exponent;
+		grisu2(digits, len, exponent, value);
+
+		// The position of the decimal point relative to the start of the digits
+		int point = len + exponent;
+
+		if (len <= point && point <= 21) {
+			// An integer, padded with zeros: 1230000
+			memcpy(p, digits, len);
+			memset(p + len, '0', point - len);
+			p += point;
+		} else if (0 < point && point <= 21) {
+			// The decimal point goes between the digits: 123.45
+			memcpy(p, digits, point);
+			p[point] = '.';
+			memcpy(p + point + 1, digits + point, len - point);
+			p += len + 1;
+		} else if (-6 < point && point <= 0) {
+			// Zeros go between the decimal point and the digits: 0.00123
+			p[0] = '0';
+			p[1] = '.';
+			memset(p + 2, '0', -point);
+			memcpy(p + 2 - point, digits, len);
+			p += 2 - point + len;
+		} else {
+			// Scientific notation: 1.23e+45
+			*p++ = digits[0];
+			if (len > 1) {
+				*p++ = '.';
+				memcpy(p, digits + 1, len - 1);
+				p += len - 1;
+			}
+			*p++ = 'e';
+			int e = point - 1;
+			if (e < 0) {
+				*p++ = '-';
+				e = -e;
+			} else {
+				*p++ = '+';
+			}
+			p += format_uint(p, (uint64_t)e);
+		}
+
+		return p - buffer;
+	}
+}
+
+size_t s2::format_int(char* buffer, int64_t value)
+{
+	if (value < 0) {
+		*buffer = '-';
+		return 1 + format_uint(buffer + 1, 0 - (uint64_t)value);
+	}
+	return format_uint(buffer, (uint64_t)value);
+}
+
+size_t s2::format_uint(char* buffer, uint64_t value)
+{
+	size_t len = count_digits(value);
+	write_digits_backwards(buffer + len, value);
+	return len;
+}
+
+size_t s2::format_hex(char* buffer, uint64_t value, bool uppercase)
+{
+	size_t len = count_hex_digits(value);
+	write_hex_backwards(buffer + len, value, uppercase);
+	return len;
+}
+
+size_t s2::format_double(char* buffer, double value)
+{
+	return format_shortest(buffer, value, DBL_MAX);
+}
+
+size_t s2::format_float(char* buffer, float value)
+{
+	return format_shortest(buffer, value, FLT_MAX);
+}
+
+void s2::string::append_int(int64_t value)
+{
+	if (value < 0) {
+		append('-');
+		append_uint(0 - (uint64_t)value);
+	} else {
+		append_uint((uint64_t)value);
+	}
+}
+
+void s2::string::append_uint(uint64_t value)
+{
+	// Count the digits first so that they can be written straight into the buffer
+	size_t len = count_digits(value);
+	ensure_memory(m_length + len + 1);
+	char* p = buffer() + m_length;
+	write_digits_backwards(p + len, value);
+	p[len] = '\0';
+	m_length += len;
+}
+
+void s2::string::append_hex(uint64_t value, bool uppercase)
+{
+	size_t len = count_hex_digits(value);
+	ensure_memory(m_length + len + 1);
+	char* p = buffer() + m_length;
+	write_hex_backwards(p + len, value, uppercase);
+	p[len] = '\0';
+	m_length += len;
+}
+
+void s2::string::append_double(double value)
+{
+	char temp[max_number_length];
+	append(temp, 0, format_double(temp, value));
+}
+
+void s2::string::append_float(float value)
+{
+	char temp[max_number_length];
+	append(temp, 0, format_float(temp, value));
+}
+
+void s2::string::appendf(const char* format, ...)
+{
+	char* buffer = (char*)S2_MALLOC(min_buffer_size);
+
+	va_list vl;
+	va_start(vl, format);
+	int len = vsnprintf(buffer, min_buffer_size, format, vl);
+	va_end(vl);
+
+	if (len >= min_buffer_size) {
+		buffer = (char*)S2_REALLOC(buffer, len + 1);
+
+		va_list vl;
+		va_start(vl, format);
+		len = vsnprintf(buffer, len + 1, format, vl);
+		va_end(vl);
+	}
+
+	append(buffer, 0, len);
+
+	S2_FREE(buffer);
+}
+
+s2::string& s2::string::operator =(const char* sz)
+{
+	if (sz == nullptr) {
+		if (!is_null()) {
+			buffer()[0] = '\0';
+		}
+		m_length = 0;
+	} else {
+		m_length = strlen(sz);
+		if (m_length == 0) {
+			if (!is_null()) {
+				buffer()[0] = '\0';
+			}
+		} else {
+			ensure_memory(m_length + 1);
+			memcpy(buffer(), sz, m_length);
+			buffer()[m_length] = '\0';
+		}
+	}
+	return *this;
+}
+
+s2::string& s2::string::operator =(const s2::string& str)
+{
+	return operator =(str.buffer());
+}
+
+s2::string& s2::string::operator =(s2::string&& str)
+{
+	if (&str == this) {
+		return *this;
+	}
+	if (!is_local()) {
+		S2_FREE(m_heap);
+	}
+	take_memory(str);
+	return *this;
+}
+
+s2::string& s2::string::operator +=(const char* sz)
+{
+	append(sz);
+	return *this;
+}
+
+s2::string& s2::string::operator +=(const s2::string& str)
+{
+	append(str.buffer(), 0, str.m_length);
+	return *this;
+}
+
+s2::string& s2::string::operator +=(s2::string&& str)
+{
+	append(static_cast<string&&>(str));
+	return *this;
+}
+
+s2::string s2::string::operator +(const char* sz) const &
+{
+	size_t len = sz != nullptr ? strlen(sz) : 0;
+
+	string ret;
+	ret.ensure_memory(m_length + len + 1);
+	ret.append(c_str(), 0, m_length);
+	ret.append(sz, 0, len);
+	return ret;
+}
+
+s2::string s2::string::operator +(const string& str) const &
+{
+	string ret;
+	ret.ensure_memory(m_length + str.m_length + 1);
+	ret.append(c_str(), 0, m_length);
+	ret.append(str.c_str(), 0, str.m_length);
+	return ret;
+}
+
+s2::string s2::string::operator +(char c) const &
+{
+	string ret;
+	ret.ensure_memory(m_length + 2);
+	ret.append(c_str(), 0, m_length);
+	ret.append(c);
+	return ret;
+}
+
+s2::string s2::string::operator +(const char* sz) &&
+{
+	append(sz);
+	return static_cast<string&&>(*this);
+}
+
+s2::string s2::string::operator +(const string& str) &&
+{
+	append(str.buffer(), 0, str.m_length);
+	return static_cast<string&&>(*this);
+}
+
+s2::string s2::string::operator +(char c) &&
+{
+	append(c);
+	return static_cast<string&&>(*this);
+}
+
+s2::string s2::string::operator +(string&& str) const &
+{
+	str.insert(c_str(), 0, m_length);
+	return static_cast<string&&>(str);
+}
+
+s2::string s2::string::operator +(string&& str) &&
+{
+	append(str.buffer(), 0, str.m_length);
+	return static_cast<string&&>(*this);
+}
+
+s2::string s2::string::trim() const
+{
+	return trim(charset::whitespace());
+}
+
+s2::string s2::string::trim(const char* sz) const
+{
+	if (sz == nullptr) {
+		return *this;
+	}
+	return trim(charset(sz));
+}
+
+s2::string s2::string::trim(const s2::charset& chars) const
+{
+	if (is_null() || chars.is_empty()) {
+		return *this;
+	}
+	stringview view = trim_view(chars);
+	return string(view.c_str(), view.len());
+}
+
+s2::stringview s2::string::trim_view() const
+{
+	return trim_view(charset::whitespace());
+}
+
+s2::stringview s2::string::trim_view(const char* sz) const
+{
+	return trim_view(charset(sz));
+}
+
+s2::stringview s2::string::trim_view(const s2::charset& chars) const
+{
+	if (is_null()) {
+		return stringview();
+	}
+	return stringview(buffer(), m_length).trim(chars);
+}
+
+void s2::string::trim_inplace()
+{
+	trim_inplace(charset::whitespace());
+}
+
+void s2::string::trim_inplace(const char* sz)
+{
+	trim_inplace(charset(sz));
+}
+
+void s2::string::trim_inplace(const s2::charset& chars)
+{
+	if (is_null()) {
+		return;
+	}
+	stringview view = trim_view(chars);
+	char* p = buffer();
+	if (view.c_str() != p) {
+		memmove(p, view.c_str(), view.len());
+	}
+	m_length = view.len();
+	p[m_length] = '\0';
+}
+
+s2::string s2::string::tolower() const
+{
+	if (is_null()) {
+		return *this;
+	}
+
+	s2::string ret;
+	ret.ensure_memory(m_length + 1);
+	char* p = ret.buffer();
+	memlower(p, buffer(), m_length);
+	p[m_length] = '\0';
+	ret.m_length = m_length;
+	return ret;
+}
+
+s2::string s2::string::toupper() const
+{
+	if (is_null()) {
+		return *this;
+	}
+
+	s2::string ret;
+	ret.ensure_memory(m_length + 1);
+	char* p = ret.buffer();
+	memupper(p, buffer(), m_length);
+	p[m_length] = '\0';
+	ret.m_length = m_length;
+	return ret;
 }
 
-bool s2::string::startswith(const char* sz) const
+void s2::string::make_lower()
 {
-	if (m_buffer == nullptr) {
-		return false;
+	if (!is_null()) {
+		memlower(buffer(), buffer(), m_length);
 	}
-	return strstr(m_buffer, sz) == m_buffer;
 }
 
-bool s2::string::endswith(const char* sz) const
+void s2::string::make_upper()
 {
-	if (m_buffer == nullptr) {
-		return false;
+	if (!is_null()) {
+		memupper(buffer(), buffer(), m_length);
 	}
-	return !strcmp(m_buffer + m_length - strlen(sz), sz);
 }
 
-s2::stringsplit s2::string::split(const char* delim, int limit) const
+int s2::string::as_int() const
 {
-	return stringsplit(m_buffer, delim, limit);
+	return stringview(*this).as_int();
 }
 
-s2::stringsplit s2::string::commandlinesplit() const
+int64_t s2::string::as_large_int() const
 {
-	return stringsplit(m_buffer, true);
+	return stringview(*this).as_large_int();
 }
 
-s2::string s2::string::substr(intptr_t start) const
+uint32_t s2::string::as_uint() const
 {
-	if (m_length == 0 || m_buffer == nullptr) {
-		return "";
-	}
-	while (start < 0) {
-		start += (intptr_t)m_length;
-	}
-	if ((size_t)start >= m_length) {
-		return "";
+	return stringview(*this).as_uint();
+}
+
+uint64_t s2::string::as_large_uint() const
+{
+	return stringview(*this).as_large_uint();
+}
+
+float s2::string::as_float() const
+{
+	return stringview(*this).as_float();
+}
+
+double s2::string::as_double() const
+{
+	return stringview(*this).as_double();
+}
+
+bool s2::string::as_bool() const
+{
+	if (is_null()) {
+		return false;
 	}
-	return string(m_buffer + start);
+	char c = buffer()[0];
+	return c == 't' || c == 'T' || c == 'y' || c == 'Y' || c == '1';
 }
 
-s2::string s2::string::substr(intptr_t start, intptr_t len) const
+s2::parseresult s2::string::parse(int32_t& value) const
 {
-	if (m_length == 0 || m_buffer == nullptr) {
-		return "";
+	return parse_number(c_str(), c_str() + m_length, value);
+}
+
+s2::parseresult s2::string::parse(int64_t& value) const
+{
+	return parse_number(c_str(), c_str() + m_length, value);
+}
+
+s2::parseresult s2::string::parse(uint32_t& value) const
+{
+	return parse_number(c_str(), c_str() + m_length, value);
+}
+
+s2::parseresult s2::string::parse(uint64_t& value) const
+{
+	return parse_number(c_str(), c_str() + m_length, value);
+}
+
+s2::parseresult s2::string::parse(float& value) const
+{
+	return parse_number(c_str(), c_str() + m_length, value);
+}
+
+s2::parseresult s2::string::parse(double& value) const
+{
+	return parse_number(c_str(), c_str() + m_length, value);
+}
+
+uint64_t s2::string::hash() const
+{
+	return stringview(c_str(), m_length).hash();
+}
+
+int s2::string::compare(const char* sz) const
+{
+	if (sz == nullptr) {
+		return m_length == 0 ? 0 : 1;
 	}
-	while (start < 0) {
-		start += (intptr_t)m_length;
+	return compare(stringview(sz));
+}
+
+int s2::string::compare(const s2::string& str) const
+{
+	return compare(stringview(str.c_str(), str.m_length));
+}
+
+int s2::string::compare(const s2::stringview& str) const
+{
+	return stringview(c_str(), m_length).compare(str);
+}
+
+bool s2::string::operator ==(const char* sz) const
+{
+	if (buffer() == sz) {
+		return true;
 	}
-	if ((size_t)start >= m_length) {
-		return "";
+	if (sz == nullptr) {
+		return m_length == 0;
 	}
-	intptr_t remainder = (intptr_t)strlen(m_buffer) + start;
-	if (len > remainder) {
-		len = remainder;
+	size_t len = strlen(sz);
+	return len == m_length && !memcmp(c_str(), sz, len);
+}
+
+bool s2::string::operator ==(const s2::string& str) const
+{
+	// Lengths are known, so different lengths never have to look at the text
+	if (m_length != str.m_length) {
+		return false;
 	}
-	return string(m_buffer + start, len);
+	return m_length == 0 || !memcmp(buffer(), str.buffer(), m_length);
 }
 
-void s2::string::append(char c)
+bool s2::string::operator ==(const s2::stringview& str) const
 {
-	append(&c, 0, 1);
+	return m_length == str.len() && !memcmp(c_str(), str.c_str(), m_length);
 }
 
-void s2::string::append(const char* sz)
+bool s2::string::operator !=(const char* sz) const
 {
-	if (sz == nullptr) {
-		return;
-	}
-	append(sz, 0, strlen(sz));
+	return !(*this == sz);
 }
 
-void s2::string::append(const char* sz, size_t len)
+bool s2::string::operator !=(const string& str) const
 {
-	if (sz == nullptr) {
-		return;
+	return !(*this == str);
+}
+
+bool s2::string::operator !=(const s2::stringview& str) const
+{
+	return !(*this == str);
+}
+
+s2::string::operator const char*() const
+{
+	if (is_null()) {
+		return "";
 	}
-	append(sz, 0, len);
+	return buffer();
 }
 
-void s2::string::append(const char* sz, size_t start, size_t len)
+static char __nullchar = '\0';
+
+char &s2::string::operator [](int index)
 {
-	if (sz == nullptr) {
-		return;
+	if (is_null()) {
+		return __nullchar;
 	}
-	ensure_memory(m_length + len + 1);
-	memcpy(m_buffer + m_length, sz + start, len);
-	m_length += len;
-	m_buffer[m_length] = '\0';
+	return buffer()[index];
 }
 
-void s2::string::insert(const char* sz, size_t pos)
+const char &s2::string::operator [](int index) const
 {
-	insert(sz, pos, strlen(sz));
+	if (is_null()) {
+		return __nullchar;
+	}
+	return buffer()[index];
 }
 
-void s2::string::insert(const char* sz, size_t pos, size_t len)
+void s2::string::set_length_unsafe(size_t len)
 {
-	ensure_memory(m_length + len + 1);
-	memmove(m_buffer + pos + len, m_buffer + pos, m_length - pos);
-	memcpy(m_buffer + pos, sz, len);
-	m_length += len;
-	m_buffer[m_length] = '\0';
+	m_length = len;
 }
 
-void s2::string::remove(size_t pos, size_t len)
+void s2::string::ensure_memory(size_t size)
 {
-	if (m_buffer == nullptr) {
+	if (m_allocSize >= size) {
 		return;
 	}
-	memmove(m_buffer + pos, m_buffer + pos + len, m_length - pos - len);
-	m_length -= len;
-	m_buffer[m_length] = '\0';
+
+	// Resize in chunks to avoid re-allocating too often
+	size_t resize = m_allocSize + m_allocSize / 2;
+	if (resize < SIZE_MAX && resize > size) {
+		size = resize;
+	}
+
+	resize_memory(size);
 }
 
-s2::string s2::string::replace(char find, char replace) const
+void s2::string::ensure_not_null()
 {
-	if (m_buffer == nullptr) {
-		return *this;
+	if (is_null()) {
+		ensure_memory(1);
+		m_local[0] = '\0';
 	}
+}
 
-	s2::string ret(*this);
-	char* p = ret.m_buffer;
-	while (*p != '\0') {
-		if (*p == find) {
-			*p = replace;
-		}
-		p++;
+void s2::string::take_memory(s2::string& str)
+{
+	if (str.is_local()) {
+		memcpy(m_local, str.m_local, S2_STRING_LOCAL_SIZE);
+	} else {
+		m_heap = str.m_heap;
 	}
-	return ret;
+	m_length = str.m_length;
+	m_allocSize = str.m_allocSize;
+
+	str.m_heap = nullptr;
+	str.m_length = 0;
+	str.m_allocSize = 0;
 }
 
-s2::string s2::string::replace(const char* find, const char* replace) const
+void s2::string::resize_memory(size_t size)
 {
-	if (m_buffer == nullptr || find == nullptr || replace == nullptr) {
-		return *this;
+	if (size <= S2_STRING_LOCAL_SIZE) {
+		// Small strings live in the local buffer, which is always the full local size
+		if (is_local()) {
+			m_allocSize = S2_STRING_LOCAL_SIZE;
+			return;
+		}
+		size = S2_STRING_LOCAL_SIZE + 1;
 	}
 
-	if (*find == '\0') {
-		return *this;
+	if (is_local()) {
+		// Move the local buffer over to the heap
+		char* heap = (char*)S2_MALLOC(size);
+		if (m_allocSize > 0) {
+			memcpy(heap, m_local, S2_STRING_LOCAL_SIZE);
+		}
+		m_heap = heap;
+	} else {
+		m_heap = (char*)S2_REALLOC(m_heap, size);
 	}
+	m_allocSize = size;
+}
+
+bool s2::operator ==(const char* sz, const string& str)
+{
+	return str == sz;
+}
 
-	size_t findlen = strlen(find);
-	size_t replacelen = strlen(replace);
+bool s2::operator !=(const char* sz, const string& str)
+{
+	return str != sz;
+}
 
-	s2::string ret(*this);
-	int index = 0;
-	while (true) {
-		char* p = strstr(ret.m_buffer + index, find);
-		if (p == nullptr) {
-			break;
-		}
-		index = (int)(p - ret.m_buffer);
+bool s2::operator <(const char* sz, const string& str)
+{
+	return str.compare(sz) > 0;
+}
+
+bool s2::operator <=(const char* sz, const string& str)
+{
+	return str.compare(sz) >= 0;
+}
 
-		ret.remove(index, findlen);
-		ret.insert(replace, index, replacelen);
+bool s2::operator >(const char* sz, const string& str)
+{
+	return str.compare(sz) < 0;
+}
 
-		index += (int)replacelen;
-	}
+bool s2::operator >=(const char* sz, const string& str)
+{
+	return str.compare(sz) <= 0;
+}
+
+s2::string s2::operator +(const char* lhs, const string& rhs)
+{
+	size_t len = lhs != nullptr ? strlen(lhs) : 0;
+
+	string ret;
+	ret.ensure_memory(len + rhs.len() + 1);
+	ret.append(lhs, 0, len);
+	ret.append(rhs.c_str(), 0, rhs.len());
 	return ret;
 }
 
-s2::string s2::string::replace(const char* findchars, char replace) const
+s2::string s2::operator +(const char* lhs, string&& rhs)
 {
-	if (m_buffer == nullptr || findchars == nullptr) {
-		return *this;
+	if (lhs != nullptr) {
+		rhs.insert(lhs, 0);
 	}
+	return static_cast<string&&>(rhs);
+}
 
-	if (*findchars == '\0') {
-		return *this;
+s2::string s2::concat(std::initializer_list<s2::stringview> pieces)
+{
+	size_t len = 0;
+	for (const s2::stringview& piece : pieces) {
+		len += piece.len();
 	}
 
-	s2::string ret(*this);
-	char* p = ret.m_buffer;
-	while (*p != '\0') {
-		if (strchr(findchars, *p) != nullptr) {
-			*p = replace;
+	string ret;
+	if (len > 0) {
+		ret.ensure_memory(len + 1);
+		for (const s2::stringview& piece : pieces) {
+			ret.append(piece.c_str(), 0, piece.len());
 		}
-		p++;
 	}
 	return ret;
 }
 
-void s2::string::setf(const char* format, ...)
+s2::string s2::strprintf(const char* format, ...)
 {
-	ensure_memory(min_buffer_size);
+	char* buffer = (char*)S2_MALLOC(min_buffer_size);
 
 	va_list vl;
 	va_start(vl, format);
-	int len = vsnprintf(m_buffer, m_allocSize, format, vl);
+	int len = vsnprintf(buffer, min_buffer_size, format, vl);
 	va_end(vl);
 
 	if (len >= min_buffer_size) {
-		ensure_memory(len + 1);
+		buffer = (char*)S2_REALLOC(buffer, len + 1);
 
 		va_list vl;
 		va_start(vl, format);
-		vsnprintf(m_buffer, m_allocSize, format, vl);
+		len = vsnprintf(buffer, len + 1, format, vl);
 		va_end(vl);
 	}
 
-	m_length = len;
+	s2::string ret = buffer;
+	S2_FREE(buffer);
+	return ret;
 }
 
-void s2::string::appendf(const char* format, ...)
+void s2::string::append(const s2::stringview& str)
 {
-	char* buffer = (char*)malloc(min_buffer_size);
-
-	va_list vl;
-	va_start(vl, format);
-	int len = vsnprintf(buffer, min_buffer_size, format, vl);
-	va_end(vl);
+	append(str.c_str(), 0, str.len());
+}
 
-	if (len >= min_buffer_size) {
-		buffer = (char*)realloc(buffer, len + 1);
+int s2::stringview::indexof_nocase(const char* sz) const
+{
+	const char* p = memfind_nocase(m_str, m_len, sz, strlen(sz));
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - m_str);
+}
 
-		va_list vl;
-		va_start(vl, format);
-		len = vsnprintf(buffer, len + 1, format, vl);
-		va_end(vl);
+int s2::stringview::lastindexof_nocase(const char* sz) const
+{
+	const char* p = memrfind_nocase(m_str, m_len, sz, strlen(sz));
+	if (p == nullptr) {
+		return -1;
 	}
+	return (int)(p - m_str);
+}
 
-	append(buffer, 0, len);
+bool s2::stringview::contains_nocase(const char* sz) const
+{
+	return memfind_nocase(m_str, m_len, sz, strlen(sz)) != nullptr;
+}
 
-	free(buffer);
+s2::splitview s2::stringview::split_view(const char* delim, int limit) const
+{
+	return splitview(m_str, m_len, delim, limit);
 }
 
-s2::string& s2::string::operator =(const char* sz)
+s2::splitview s2::stringview::split_view(const s2::charset& delims, int limit) const
 {
-	if (sz == nullptr) {
-		if (m_buffer != nullptr) {
-			m_buffer[0] = '\0';
-		}
-		m_length = 0;
-	} else {
-		m_length = strlen(sz);
-		if (m_length == 0) {
-			if (m_buffer != nullptr) {
-				m_buffer[0] = '\0';
-			}
-		} else {
-			ensure_memory(m_length + 1);
-			memcpy(m_buffer, sz, m_length);
-			m_buffer[m_length] = '\0';
-		}
+	return splitview(m_str, m_len, delims, limit);
+}
+
+int s2::stringview::indexof(char c) const
+{
+	const char* p = memfind(m_str, m_len, c);
+	if (p == nullptr) {
+		return -1;
 	}
-	return *this;
+	return (int)(p - m_str);
+}
+
+int s2::stringview::indexof(const s2::stringview& sz) const
+{
+	const char* p = memfind(m_str, m_len, sz.m_str, sz.m_len);
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - m_str);
 }
 
-s2::string& s2::string::operator =(const s2::string& str)
+int s2::stringview::lastindexof(char c) const
 {
-	return operator =(str.m_buffer);
+	const char* p = memrfind(m_str, m_len, c);
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - m_str);
 }
 
-s2::string& s2::string::operator +=(const char* sz)
+int s2::stringview::lastindexof(const s2::stringview& sz) const
 {
-	append(sz);
-	return *this;
+	const char* p = memrfind(m_str, m_len, sz.m_str, sz.m_len);
+	if (p == nullptr) {
+		return -1;
+	}
+	return (int)(p - m_str);
 }
 
-s2::string& s2::string::operator +=(const s2::string& str)
+bool s2::stringview::contains(const s2::stringview& sz) const
 {
-	return operator +=(str.m_buffer);
+	return memfind(m_str, m_len, sz.m_str, sz.m_len) != nullptr;
 }
 
-s2::string s2::string::operator +(const char* sz) const
+bool s2::stringview::startswith(const s2::stringview& sz) const
 {
-	return string(*this) += sz;
+	return sz.m_len <= m_len && !memcmp(m_str, sz.m_str, sz.m_len);
 }
 
-s2::string s2::string::operator +(const string& str) const
+bool s2::stringview::endswith(const s2::stringview& sz) const
 {
-	return string(*this) += str;
+	return sz.m_len <= m_len && !memcmp(m_str + m_len - sz.m_len, sz.m_str, sz.m_len);
 }
 
-s2::string s2::string::trim() const
+s2::stringview s2::stringview::substr(intptr_t start) const
 {
-	return trim("\n\r\t ");
+	return substr(start, (intptr_t)m_len);
 }
 
-s2::string s2::string::trim(const char* sz) const
+s2::stringview s2::stringview::substr(intptr_t start, intptr_t len) const
 {
-	if (m_buffer == nullptr || sz == nullptr || strlen(sz) == 0) {
-		return *this;
+	if (m_len == 0) {
+		return stringview(m_str, 0);
 	}
-
-	int len = (int)strlen(m_buffer);
-	char* p = m_buffer;
-	while (*p != '\0') {
-		if (strchr(sz, *p) == nullptr) {
-			break;
-		}
-		p++;
+	while (start < 0) {
+		start += (intptr_t)m_len;
 	}
-
-	char* pp = m_buffer + (len - 1);
-	while (pp > p) {
-		if (strchr(sz, *pp) == nullptr) {
-			break;
-		}
-		pp--;
+	if ((size_t)start >= m_len || len <= 0) {
+		return stringview(m_str + m_len, 0);
 	}
-
-	return string(p, (pp - p) + 1);
+	size_t remainder = m_len - (size_t)start;
+	if ((size_t)len > remainder) {
+		len = (intptr_t)remainder;
+	}
+	return stringview(m_str + start, (size_t)len);
 }
 
-s2::string s2::string::tolower() const
+s2::stringview s2::stringview::trim() const
 {
-	if (m_buffer == nullptr) {
-		return *this;
-	}
+	return trim(charset::whitespace());
+}
 
-	s2::string ret = *this;
-	char* p = ret.m_buffer;
-	while (*p != '\0') {
-		*p = ::tolower(*p);
-		p++;
-	}
-	return ret;
+s2::stringview s2::stringview::trim(const char* sz) const
+{
+	return trim(charset(sz));
 }
 
-s2::string s2::string::toupper() const
+s2::stringview s2::stringview::trim(const s2::charset& chars) const
 {
-	if (m_buffer == nullptr) {
-		return *this;
+	const char* pEnd = m_str + m_len;
+	const char* p = chars.find_not(m_str, pEnd);
+	while (pEnd > p && chars.contains(*(pEnd - 1))) {
+		pEnd--;
 	}
+	return stringview(p, pEnd - p);
+}
 
-	s2::string ret = *this;
-	char* p = ret.m_buffer;
-	while (*p != '\0') {
-		*p = ::toupper(*p);
+// The as_ functions are lenient like atoi: leading whitespace is skipped, and 0 is returned when parsing fails
+static const char* skip_number_whitespace(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || (*p >= '\t' && *p <= '\r'))) {
 		p++;
 	}
-	return ret;
+	return p;
 }
 
-int s2::string::as_int() const
+int s2::stringview::as_int() const
 {
-	if (m_buffer == nullptr) {
-		return 0;
-	}
-	return atoi(m_buffer);
+	int32_t ret = 0;
+	parse_number(skip_number_whitespace(m_str, m_str + m_len), m_str + m_len, ret);
+	return ret;
 }
 
-int64_t s2::string::as_large_int() const
+int64_t s2::stringview::as_large_int() const
 {
-	if (m_buffer == nullptr) {
-		return 0;
-	}
-	return (int64_t)atoll(m_buffer);
+	int64_t ret = 0;
+	parse_number(skip_number_whitespace(m_str, m_str + m_len), m_str + m_len, ret);
+	return ret;
 }
 
-uint32_t s2::string::as_uint() const
+uint32_t s2::stringview::as_uint() const
 {
-	if (m_buffer == nullptr) {
-		return 0;
-	}
-	return (uint32_t)strtoul(m_buffer, nullptr, 10);
+	uint32_t ret = 0;
+	parse_number(skip_number_whitespace(m_str, m_str + m_len), m_str + m_len, ret);
+	return ret;
 }
 
-uint64_t s2::string::as_large_uint() const
+uint64_t s2::stringview::as_large_uint() const
 {
-	if (m_buffer == nullptr) {
-		return 0;
-	}
-	return (uint64_t)strtoull(m_buffer, nullptr, 10);
+	uint64_t ret = 0;
+	parse_number(skip_number_whitespace(m_str, m_str + m_len), m_str + m_len, ret);
+	return ret;
 }
 
-float s2::string::as_float() const
+float s2::stringview::as_float() const
 {
-	if (m_buffer == nullptr) {
-		return 0;
-	}
-	return (float)atof(m_buffer);
+	float ret = 0;
+	parse_number(skip_number_whitespace(m_str, m_str + m_len), m_str + m_len, ret);
+	return ret;
 }
 
-double s2::string::as_double() const
+double s2::stringview::as_double() const
 {
-	if (m_buffer == nullptr) {
-		return 0;
-	}
-	return atof(m_buffer);
+	double ret = 0;
+	parse_number(skip_number_whitespace(m_str, m_str + m_len), m_str + m_len, ret);
+	return ret;
 }
 
-bool s2::string::as_bool() const
+bool s2::stringview::as_bool() const
 {
-	if (m_buffer == nullptr) {
+	if (m_len == 0) {
 		return false;
 	}
-	char c = m_buffer[0];
+	char c = m_str[0];
 	return c == 't' || c == 'T' || c == 'y' || c == 'Y' || c == '1';
 }
 
-bool s2::string::operator ==(const char* sz) const
+uint64_t s2::stringview::hash() const
 {
-	if (m_buffer == sz) {
-		return true;
-	}
-	if (m_buffer == nullptr) {
-		return sz == nullptr || strlen(sz) == 0;
+	// This is the same modified MurmurHash64A by Austin Appleby as in default_hashers_hashtable
+
+	const uint64_t seed = 0x2f97bc371e161991llu;
+	const uint64_t m = 0xc6a4a7935bd1e995llu;
+	const int r = 47;
+
+	int len = (int)m_len;
+
+	uint64_t h = seed ^ (len * m);
+
+	const unsigned char* data = (const unsigned char*)m_str;
+	const unsigned char* end = data + (len / 8) * 8;
+
+	while (data != end) {
+		uint64_t k;
+		memcpy(&k, data, sizeof(k));
+		data += 8;
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		h ^= k;
+		h *= m;
 	}
-	if (m_buffer != nullptr && sz == nullptr) {
-		return false;
+
+	int rest = len & 7;
+	if (rest > 0) {
+		for (int j = rest - 1; j >= 0; j--) {
+			h ^= uint64_t(data[j]) << (j * 8);
+		}
+		h *= m;
 	}
-	return !strcmp(m_buffer, sz);
-}
 
-bool s2::string::operator ==(const s2::string& str) const
-{
-	return (*this == str.m_buffer);
-}
+	h ^= h >> r;
+	h *= m;
+	h ^= h >> r;
 
-bool s2::string::operator !=(const char* sz) const
-{
-	return !(*this == sz);
+	return h;
 }
 
-bool s2::string::operator !=(const string& str) const
-{
-	return !(*this == str);
-}
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define S2_STRING_LITTLE_ENDIAN
+#endif
 
-s2::string::operator const char*() const
+namespace s2
 {
-	if (m_buffer == nullptr) {
-		return "";
+	static inline bool is_digit(char c)
+	{
+		return (unsigned char)(c - '0') < 10;
 	}
-	return m_buffer;
-}
 
-static char __nullchar = '\0';
+#if defined(S2_STRING_LITTLE_ENDIAN)
+	// Checks whether 8 characters loaded as a little endian integer are all digits
+	static inline bool is_eight_digits(uint64_t block)
+	{
+		return ((block & 0xF0F0F0F0F0F0F0F0llu) | (((block + 0x0606060606060606llu) & 0xF0F0F0F0F0F0F0F0llu) >> 4)) == 0x3333333333333333llu;
+	}
 
-char &s2::string::operator [](int index)
-{
-	if (m_buffer == nullptr) {
-		return __nullchar;
+	// Converts 8 digits loaded as a little endian integer to their value, combining pairs of digits in each step
+	static inline uint64_t parse_eight_digits(uint64_t block)
+	{
+		block -= 0x3030303030303030llu;
+		block = (block * 10) + (block >> 8);
+		block = (((block & 0x000000FF000000FFllu) * (100 + (1000000llu << 32))) + (((block >> 16) & 0x000000FF000000FFllu) * (1 + (10000llu << 32)))) >> 32;
+		return (uint32_t)block;
 	}
-	return m_buffer[index];
-}
+#endif
 
-const char &s2::string::operator [](int index) const
-{
-	if (m_buffer == nullptr) {
-		return __nullchar;
+	// Parses a run of digits into value and returns the end of the digits. All digits are consumed even when they
+	// don't fit in 64 bits, in which case overflow is set.
+	static const char* parse_digits(const char* p, const char* last, uint64_t& value, bool& overflow)
+	{
+		uint64_t v = 0;
+		overflow = false;
+
+#if defined(S2_STRING_LITTLE_ENDIAN)
+		// Take 8 digits at a time for as long as that can't overflow
+		while (last - p >= 8 && v < 100000000000llu) {
+			uint64_t block;
+			memcpy(&block, p, sizeof(block));
+			if (!is_eight_digits(block)) {
+				break;
+			}
+			v = v * 100000000 + parse_eight_digits(block);
+			p += 8;
+		}
+#endif
+
+		while (p < last && is_digit(*p)) {
+			uint64_t digit = (uint64_t)(*p - '0');
+			if (v > 1844674407370955161llu || (v == 1844674407370955161llu && digit > 5)) {
+				overflow = true;
+			} else {
+				v = v * 10 + digit;
+			}
+			p++;
+		}
+
+		value = v;
+		return p;
 	}
-	return m_buffer[index];
-}
 
-void s2::string::set_length_unsafe(size_t len)
-{
-	m_length = len;
-}
+	static parseresult parse_integer(const char* first, const char* last, uint64_t& magnitude, bool& negative, bool allowNegative)
+	{
+		const char* p = first;
 
-void s2::string::ensure_memory(size_t size)
-{
-	if (m_buffer != nullptr && m_allocSize >= size) {
-		return;
+		negative = false;
+		if (p < last && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			if (negative && !allowNegative) {
+				return { first, parseerror::invalid };
+			}
+			p++;
+		}
+
+		if (p == last || !is_digit(*p)) {
+			return { first, parseerror::invalid };
+		}
+
+		bool overflow;
+		p = parse_digits(p, last, magnitude, overflow);
+		return { p, overflow ? parseerror::out_of_range : parseerror::none };
 	}
 
-	// Resize in chunks to avoid re-allocating too often
-	size_t resize = m_allocSize + m_allocSize / 2;
-	if (resize < SIZE_MAX && resize > size) {
-		size = resize;
+	// A decimal number split up into its parts, so that the value is mantissa * 10^exponent
+	struct decimalparts
+	{
+		uint64_t mantissa;
+		int64_t exponent;
+		bool negative;
+
+		// Set when there were more significant digits than fit in the mantissa
+		bool truncated;
+	};
+
+	static const int max_mantissa_digits = 19;
+
+	static inline const char* scan_mantissa_digits(const char* p, const char* last, decimalparts& parts, int& digits, bool fraction)
+	{
+#if defined(S2_STRING_LITTLE_ENDIAN)
+		while (digits + 8 <= max_mantissa_digits && last - p >= 8) {
+			uint64_t block;
+			memcpy(&block, p, sizeof(block));
+			if (!is_eight_digits(block)) {
+				break;
+			}
+			parts.mantissa = parts.mantissa * 100000000 + parse_eight_digits(block);
+			if (parts.mantissa != 0) {
+				digits += 8;
+			}
+			if (fraction) {
+				parts.exponent -= 8;
+			}
+			p += 8;
+		}
+#endif
+
+		while (p < last && is_digit(*p)) {
+			uint64_t digit = (uint64_t)(*p - '0');
+			if (digits < max_mantissa_digits) {
+				parts.mantissa = parts.mantissa * 10 + digit;
+				if (parts.mantissa != 0) {
+					digits++;
+				}
+				if (fraction) {
+					parts.exponent--;
+				}
+			} else {
+				// Digits that don't fit anymore only move the decimal point in the integer part
+				if (!fraction) {
+					parts.exponent++;
+				}
+				if (digit != 0) {
+					parts.truncated = true;
+				}
+			}
+			p++;
+		}
+		return p;
 	}
 
-	resize_memory(size);
+	// Scans a decimal number with an optional sign, fraction and exponent. Returns nullptr if there is no number.
+	static const char* scan_decimal(const char* first, const char* last, decimalparts& parts)
+	{
+		const char* p = first;
+
+		parts.mantissa = 0;
+		parts.exponent = 0;
+		parts.negative = false;
+		parts.truncated = false;
+
+		if (p < last && (*p == '-' || *p == '+')) {
+			parts.negative = *p == '-';
+			p++;
+		}
+
+		int digits = 0;
+		const char* start = p;
+		p = scan_mantissa_digits(p, last, parts, digits, false);
+		bool anyDigits = p != start;
+
+		if (p < last && *p == '.') {
+			start = ++p;
+			p = scan_mantissa_digits(p, last, parts, digits, true);
+			anyDigits = anyDigits || p != start;
+		}
+
+		if (!anyDigits) {
+			return nullptr;
+		}
+
+		// The exponent is only part of the number if it has digits
+		if (p < last && (*p == 'e' || *p == 'E')) {
+			const char* e = p + 1;
+			bool negativeExponent = false;
+			if (e < last && (*e == '-' || *e == '+')) {
+				negativeExponent = *e == '-';
+				e++;
+			}
+			if (e < last && is_digit(*e)) {
+				int64_t exponent = 0;
+				while (e < last && is_digit(*e)) {
+					if (exponent < 100000) {
+						exponent = exponent * 10 + (*e - '0');
+					}
+					e++;
+				}
+				parts.exponent += negativeExponent ? -exponent : exponent;
+				p = e;
+			}
+		}
+
+		return p;
+	}
+
+	static bool match_nocase(const char* p, const char* last, const char* word)
+	{
+		size_t len = strlen(word);
+		return (size_t)(last - p) >= len && memeq_nocase(p, word, len);
+	}
+
+	// Scans "inf", "infinity" or "nan" with an optional sign. Returns nullptr if it's none of those.
+	static const char* scan_special(const char* first, const char* last, bool& negative, bool& nan)
+	{
+		const char* p = first;
+		negative = false;
+		if (p < last && (*p == '-' || *p == '+')) {
+			negative = *p == '-';
+			p++;
+		}
+
+		if (match_nocase(p, last, "nan")) {
+			nan = true;
+			return p + 3;
+		}
+		if (match_nocase(p, last, "infinity")) {
+			nan = false;
+			return p + 8;
+		}
+		if (match_nocase(p, last, "inf")) {
+			nan = false;
+			return p + 3;
+		}
+		return nullptr;
+	}
+
+	// Fallback for numbers that the fast paths can't do exactly. The number is copied so that it's null-terminated, and
+	// the decimal point is swapped for the one strtod expects in the current locale.
+	template<typename T>
+	static T parse_decimal_fallback(const char* first, const char* last, T (*convert)(const char*, char**))
+	{
+		char stackBuffer[128];
+		size_t len = last - first;
+		char* buffer = len < sizeof(stackBuffer) ? stackBuffer : (char*)S2_MALLOC(len + 1);
+
+		char decimalPoint = localeconv()->decimal_point[0];
+		for (size_t i = 0; i < len; i++) {
+			buffer[i] = first[i] == '.' ? decimalPoint : first[i];
+		}
+		buffer[len] = '\0';
+
+		T ret = convert(buffer, nullptr);
+
+		if (buffer != stackBuffer) {
+			S2_FREE(buffer);
+		}
+		return ret;
+	}
+
+	static double strtod_wrapper(const char* str, char** end) { return strtod(str, end); }
+	static float strtof_wrapper(const char* str, char** end) { return strtof(str, end); }
+
+	static const double exact_double_powers_of_ten[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	static const float exact_float_powers_of_ten[] = {
+		1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+	};
+
+	static const uint64_t integer_powers_of_ten[] = {
+		1llu, 10llu, 100llu, 1000llu, 10000llu, 100000llu, 1000000llu, 10000000llu, 100000000llu, 1000000000llu,
+		10000000000llu, 100000000000llu, 1000000000000llu, 10000000000000llu, 100000000000000llu, 1000000000000000llu,
+	};
+
+	// Clinger's fast path: when both the mantissa and the power of ten are exactly representable, a single
+	// multiplication or division gives the correctly rounded result. Returns false if the number needs the slow path.
+	static bool decimal_to_double_fast(const decimalparts& parts, double& value)
+	{
+		const uint64_t maxMantissa = 1llu << 53;
+		if (parts.truncated || parts.mantissa > maxMantissa) {
+			return false;
+		}
+
+		if (parts.exponent >= -22 && parts.exponent <= 22) {
+			double v = (double)parts.mantissa;
+			if (parts.exponent < 0) {
+				v /= exact_double_powers_of_ten[-parts.exponent];
+			} else {
+				v *= exact_double_powers_of_ten[parts.exponent];
+			}
+			value = parts.negative ? -v : v;
+			return true;
+		}
+
+		// Numbers like 123e25 can still take the fast path by moving some of the exponent into the mantissa
+		if (parts.exponent > 22 && parts.exponent <= 22 + 15) {
+			uint64_t factor = integer_powers_of_ten[parts.exponent - 22];
+			if (parts.mantissa > maxMantissa / factor) {
+				return false;
+			}
+			double v = (double)(parts.mantissa * factor) * exact_double_powers_of_ten[22];
+			value = parts.negative ? -v : v;
+			return true;
+		}
+
+		return false;
+	}
+
+	static bool decimal_to_float_fast(const decimalparts& parts, float& value)
+	{
+		const uint64_t maxMantissa = 1llu << 24;
+		if (parts.truncated || parts.mantissa > maxMantissa || parts.exponent < -10 || parts.exponent > 10) {
+			return false;
+		}
+
+		float v = (float)parts.mantissa;
+		if (parts.exponent < 0) {
+			v /= exact_float_powers_of_ten[-parts.exponent];
+		} else {
+			v *= exact_float_powers_of_ten[parts.exponent];
+		}
+		value = parts.negative ? -v : v;
+		return true;
+	}
 }
 
-void s2::string::ensure_not_null()
+s2::parseresult s2::parse_number(const char* first, const char* last, int32_t& value)
 {
-	if (m_buffer == nullptr) {
-		ensure_memory(1);
-		m_buffer[0] = '\0';
+	uint64_t magnitude;
+	bool negative;
+	parseresult ret = parse_integer(first, last, magnitude, negative, true);
+	if (ret.error == parseerror::none) {
+		if (magnitude > (negative ? 2147483648llu : 2147483647llu)) {
+			ret.error = parseerror::out_of_range;
+		} else {
+			value = (int32_t)(negative ? 0 - magnitude : magnitude);
+		}
 	}
+	return ret;
 }
 
-void s2::string::resize_memory(size_t size)
+s2::parseresult s2::parse_number(const char* first, const char* last, int64_t& value)
 {
-	m_allocSize = size;
-	m_buffer = (char*)realloc(m_buffer, m_allocSize);
+	uint64_t magnitude;
+	bool negative;
+	parseresult ret = parse_integer(first, last, magnitude, negative, true);
+	if (ret.error == parseerror::none) {
+		if (magnitude > (negative ? 9223372036854775808llu : 9223372036854775807llu)) {
+			ret.error = parseerror::out_of_range;
+		} else {
+			value = (int64_t)(negative ? 0 - magnitude : magnitude);
+		}
+	}
+	return ret;
 }
 
-bool s2::operator ==(const char* sz, const string& str)
+s2::parseresult s2::parse_number(const char* first, const char* last, uint32_t& value)
 {
-	return str == sz;
+	uint64_t magnitude;
+	bool negative;
+	parseresult ret = parse_integer(first, last, magnitude, negative, false);
+	if (ret.error == parseerror::none) {
+		if (magnitude > 4294967295llu) {
+			ret.error = parseerror::out_of_range;
+		} else {
+			value = (uint32_t)magnitude;
+		}
+	}
+	return ret;
 }
 
-s2::string s2::operator +(const char* lhs, const string& rhs)
+s2::parseresult s2::parse_number(const char* first, const char* last, uint64_t& value)
 {
-	return string(lhs) += rhs;
+	uint64_t magnitude;
+	bool negative;
+	parseresult ret = parse_integer(first, last, magnitude, negative, false);
+	if (ret.error == parseerror::none) {
+		value = magnitude;
+	}
+	return ret;
 }
 
-s2::string s2::strprintf(const char* format, ...)
+s2::parseresult s2::parse_number(const char* first, const char* last, float& value)
 {
-	char* buffer = (char*)malloc(min_buffer_size);
-
-	va_list vl;
-	va_start(vl, format);
-	int len = vsnprintf(buffer, min_buffer_size, format, vl);
-	va_end(vl);
+	decimalparts parts;
+	const char* p = scan_decimal(first, last, parts);
+	if (p == nullptr) {
+		bool negative, nan;
+		p = scan_special(first, last, negative, nan);
+		if (p == nullptr) {
+			return { first, parseerror::invalid };
+		}
+		value = nan ? NAN : (negative ? -INFINITY : INFINITY);
+		return { p, parseerror::none };
+	}
 
-	if (len >= min_buffer_size) {
-		buffer = (char*)realloc(buffer, len + 1);
+	float v;
+	if (parts.mantissa == 0) {
+		v = parts.negative ? -0.0f : 0.0f;
+	} else if (!decimal_to_float_fast(parts, v)) {
+		v = parse_decimal_fallback<float>(first, p, strtof_wrapper);
+		if (v > FLT_MAX || v < -FLT_MAX) {
+			return { p, parseerror::out_of_range };
+		}
+	}
+	value = v;
+	return { p, parseerror::none };
+}
 
-		va_list vl;
-		va_start(vl, format);
-		len = vsnprintf(buffer, len + 1, format, vl);
-		va_end(vl);
+s2::parseresult s2::parse_number(const char* first, const char* last, double& value)
+{
+	decimalparts parts;
+	const char* p = scan_decimal(first, last, parts);
+	if (p == nullptr) {
+		bool negative, nan;
+		p = scan_special(first, last, negative, nan);
+		if (p == nullptr) {
+			return { first, parseerror::invalid };
+		}
+		value = nan ? (double)NAN : (negative ? -(double)INFINITY : (double)INFINITY);
+		return { p, parseerror::none };
 	}
 
-	s2::string ret = buffer;
-	free(buffer);
-	return ret;
+	double v;
+	if (parts.mantissa == 0) {
+		v = parts.negative ? -0.0 : 0.0;
+	} else if (!decimal_to_double_fast(parts, v)) {
+		v = parse_decimal_fallback<double>(first, p, strtod_wrapper);
+		if (v > DBL_MAX || v < -DBL_MAX) {
+			return { p, parseerror::out_of_range };
+		}
+	}
+	value = v;
+	return { p, parseerror::none };
 }
 
 s2::stringsplit::stringsplit(const char* sz, const char* delim, int limit)
@@ -1005,9 +3609,9 @@ s2::stringsplit::stringsplit(const stringsplit &copy)
 s2::stringsplit::~stringsplit()
 {
 	for (size_t i = 0; i < m_length; i++) {
-		free(m_buffer[i]);
+		S2_FREE(m_buffer[i]);
 	}
-	free(m_buffer);
+	S2_FREE(m_buffer);
 }
 
 size_t s2::stringsplit::len() const
@@ -1028,8 +3632,8 @@ const char* s2::stringsplit::c_str(size_t index) const
 void s2::stringsplit::add(const char* sz, size_t len)
 {
 	m_length++;
-	m_buffer = (char**)realloc(m_buffer, m_length * sizeof(char*));
-	char* p = (char*)malloc(len + 1);
+	m_buffer = (char**)S2_REALLOC(m_buffer, m_length * sizeof(char*));
+	char* p = (char*)S2_MALLOC(len + 1);
 	memcpy(p, sz, len);
 	p[len] = '\0';
 	m_buffer[m_length - 1] = p;
@@ -1039,14 +3643,14 @@ void s2::stringsplit::add(const char* sz, size_t len)
 s2::str_to_wide::str_to_wide(const char* src)
 {
 	m_size = MultiByteToWideChar(CP_UTF8, 0, src, -1, 0, 0);
-	m_buffer = (wchar_t*)malloc(m_size * sizeof(wchar_t));
+	m_buffer = (wchar_t*)S2_MALLOC(m_size * sizeof(wchar_t));
 	MultiByteToWideChar(CP_UTF8, 0, src, -1, m_buffer, m_size);
 }
 
 s2::str_to_utf8::str_to_utf8(const wchar_t* src)
 {
 	m_size = WideCharToMultiByte(CP_UTF8, 0, src, -1, 0, 0, 0, 0);
-	m_buffer = (char*)malloc(m_size * sizeof(char));
+	m_buffer = (char*)S2_MALLOC(m_size * sizeof(char));
 	WideCharToMultiByte(CP_UTF8, 0, src, -1, m_buffer, m_size, 0, 0);
 }
 #endif
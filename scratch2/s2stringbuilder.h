@@ -0,0 +1,296 @@
+#pragma once
+
+#define S2_USING_STRINGBUILDER
+
+#include "s2string.h"
+
+#ifndef S2_STRINGBUILDER_CHUNK_SIZE
+#define S2_STRINGBUILDER_CHUNK_SIZE 4096
+#endif
+
+namespace s2
+{
+	// Builds a string out of a chain of fixed-size chunks. Appending never has to move existing data around, and the
+	// final string is only put together once, either into a single s2::string or by writing each chunk out separately.
+	class stringbuilder
+	{
+	private:
+		struct chunk
+		{
+			chunk* next;
+			size_t size;
+			size_t capacity;
+
+			inline char* data() { return (char*)(this + 1); }
+			inline const char* data() const { return (const char*)(this + 1); }
+		};
+
+		chunk* m_first = nullptr;
+		chunk* m_last = nullptr;
+		size_t m_length = 0;
+		size_t m_chunkSize;
+
+	public:
+		stringbuilder(size_t chunkSize = S2_STRINGBUILDER_CHUNK_SIZE);
+		stringbuilder(const stringbuilder& copy) = delete;
+		~stringbuilder();
+
+		// Returns the total length of everything appended so far.
+		size_t len() const;
+
+		// Removes all contents, but keeps the first chunk around to be re-used.
+		void clear();
+
+		// Makes sure that the next given amount of bytes can be appended without allocating, and will be contiguous.
+		void reserve(size_t size);
+
+		void append(char c);
+		void append(const char* sz);
+		void append(const char* sz, size_t len);
+		void append(const string& str);
+		void append(const stringview& str);
+		void appendf(const char* format, ...);
+
+		void append_int(int64_t value);
+		void append_uint(uint64_t value);
+		void append_double(double value);
+
+		// Puts all chunks together into a single string, using a single allocation.
+		string to_string() const;
+
+		// Copies all chunks into the given buffer, which must be at least len() bytes. No null terminator is written.
+		void copy_to(char* buffer) const;
+
+		// Fills the given array with views of each chunk, in order, and returns the number of chunks. If there are more
+		// chunks than max, only the first max views are written, but the total number of chunks is still returned.
+		size_t segments(stringview* out, size_t max) const;
+
+		// Writes each chunk to the given writer by calling `writer.write(buffer, size)`, for example an s2::file.
+		template<typename TWriter>
+		void write_to(TWriter& writer) const
+		{
+			for (const chunk* c = m_first; c != nullptr; c = c->next) {
+				if (c->size > 0) {
+					writer.write(c->data(), c->size);
+				}
+			}
+		}
+
+	private:
+		// Returns a pointer to at least the given amount of free bytes at the end of the last chunk.
+		char* prepare(size_t size);
+		void add_chunk(size_t capacity);
+	};
+}
+
+#if defined(S2_IMPL)
+#include <cstdio>
+#include <cstdarg>
+
+s2::stringbuilder::stringbuilder(size_t chunkSize)
+{
+	m_chunkSize = chunkSize > 0 ? chunkSize : S2_STRINGBUILDER_CHUNK_SIZE;
+}
+
+s2::stringbuilder::~stringbuilder()
+{
+	chunk* c = m_first;
+	while (c != nullptr) {
+		chunk* next = c->next;
+		S2_FREE(c);
+		c = next;
+	}
+}
+
+size_t s2::stringbuilder::len() const
+{
+	return m_length;
+}
+
+void s2::stringbuilder::clear()
+{
+	if (m_first == nullptr) {
+		return;
+	}
+
+	chunk* c = m_first->next;
+	while (c != nullptr) {
+		chunk* next = c->next;
+		S2_FREE(c);
+		c = next;
+	}
+
+	m_first->next = nullptr;
+	m_first->size = 0;
+	m_last = m_first;
+	m_length = 0;
+}
+
+void s2::stringbuilder::reserve(size_t size)
+{
+	prepare(size);
+}
+
+void s2::stringbuilder::append(char c)
+{
+	*prepare(1) = c;
+	m_last->size++;
+	m_length++;
+}
+
+void s2::stringbuilder::append(const char* sz)
+{
+	if (sz == nullptr) {
+		return;
+	}
+	append(sz, strlen(sz));
+}
+
+void s2::stringbuilder::append(const char* sz, size_t len)
+{
+	if (sz == nullptr) {
+		return;
+	}
+
+	m_length += len;
+
+	// Fill up the rest of the last chunk first, then continue into new chunks
+	while (len > 0) {
+		if (m_last == nullptr || m_last->size == m_last->capacity) {
+			add_chunk(m_chunkSize);
+		}
+
+		size_t available = m_last->capacity - m_last->size;
+		size_t n = len < available ? len : available;
+		memcpy(m_last->data() + m_last->size, sz, n);
+		m_last->size += n;
+		sz += n;
+		len -= n;
+	}
+}
+
+void s2::stringbuilder::append(const s2::string& str)
+{
+	append(str.c_str(), str.len());
+}
+
+void s2::stringbuilder::append(const s2::stringview& str)
+{
+	append(str.c_str(), str.len());
+}
+
+void s2::stringbuilder::appendf(const char* format, ...)
+{
+	// Try to format directly into the last chunk first
+	size_t available = 0;
+	char* p = nullptr;
+	if (m_last != nullptr) {
+		available = m_last->capacity - m_last->size;
+		p = m_last->data() + m_last->size;
+	}
+
+	va_list vl;
+	va_start(vl, format);
+	int len = vsnprintf(p, available, format, vl);
+	va_end(vl);
+
+	if (len < 0) {
+		return;
+	}
+
+	if ((size_t)len >= available) {
+		// It didn't fit (vsnprintf needs room for a null terminator), so format again into fresh memory
+		p = prepare(len + 1);
+
+		va_start(vl, format);
+		vsnprintf(p, len + 1, format, vl);
+		va_end(vl);
+	}
+
+	m_last->size += len;
+	m_length += len;
+}
+
+void s2::stringbuilder::append_int(int64_t value)
+{
+	size_t len = s2::format_int(prepare(s2::max_number_length), value);
+	m_last->size += len;
+	m_length += len;
+}
+
+void s2::stringbuilder::append_uint(uint64_t value)
+{
+	size_t len = s2::format_uint(prepare(s2::max_number_length), value);
+	m_last->size += len;
+	m_length += len;
+}
+
+void s2::stringbuilder::append_double(double value)
+{
+	size_t len = s2::format_double(prepare(s2::max_number_length), value);
+	m_last->size += len;
+	m_length += len;
+}
+
+s2::string s2::stringbuilder::to_string() const
+{
+	s2::string ret;
+	ret.ensure_memory(m_length + 1);
+	char* p = &ret[0];
+	copy_to(p);
+	p[m_length] = '\0';
+	ret.set_length_unsafe(m_length);
+	return ret;
+}
+
+void s2::stringbuilder::copy_to(char* buffer) const
+{
+	for (const chunk* c = m_first; c != nullptr; c = c->next) {
+		memcpy(buffer, c->data(), c->size);
+		buffer += c->size;
+	}
+}
+
+size_t s2::stringbuilder::segments(s2::stringview* out, size_t max) const
+{
+	size_t count = 0;
+	for (const chunk* c = m_first; c != nullptr; c = c->next) {
+		if (c->size == 0) {
+			continue;
+		}
+		if (count < max) {
+			out[count] = s2::stringview(c->data(), c->size);
+		}
+		count++;
+	}
+	return count;
+}
+
+char* s2::stringbuilder::prepare(size_t size)
+{
+	if (m_last == nullptr || m_last->capacity - m_last->size < size) {
+		add_chunk(size > m_chunkSize ? size : m_chunkSize);
+	}
+	return m_last->data() + m_last->size;
+}
+
+void s2::stringbuilder::add_chunk(size_t capacity)
+{
+	// Re-use chunks that are kept around after clear()
+	if (m_last != nullptr && m_last->size == 0 && m_last->capacity >= capacity) {
+		return;
+	}
+
+	chunk* c = (chunk*)S2_MALLOC(sizeof(chunk) + capacity);
+	c->next = nullptr;
+	c->size = 0;
+	c->capacity = capacity;
+
+	if (m_last == nullptr) {
+		m_first = c;
+	} else {
+		m_last->next = c;
+	}
+	m_last = c;
+}
+#endif
@@ -31,6 +31,60 @@ namespace s2
 		// and `world`. You should not combine multiple absolute paths using this function.
 		s2::string join(const s2::stringview& pathA, const s2::stringview& pathB);
 
+		// Combines any amount of paths into one, with the same rules as joining them two at a time from left to right,
+		// but allocating only once. For example, `join({ "hello", "/world/", "foo.txt" })` will return
+		// `hello/world/foo.txt`.
+		s2::string join(std::initializer_list<s2::stringview> paths);
+
+		template<typename... TPaths>
+		inline s2::string join(const s2::stringview& pathA, const s2::stringview& pathB, const s2::stringview& pathC, const TPaths&... paths)
+		{
+			return join({ pathA, pathB, pathC, paths... });
+		}
+
+		// Builds a path out of components that can be pushed and popped again, using the same rules as join. The buffer
+		// is kept between pops and pushes, so walking a directory tree with it doesn't allocate once the buffer has grown
+		// to the deepest path.
+		class builder
+		{
+		private:
+			s2::string m_path;
+			size_t m_rootLen = 0;
+
+			// The length of the path before each push that hasn't been popped yet
+			size_t* m_marks = nullptr;
+			size_t m_numMarks = 0;
+			size_t m_marksCapacity = 0;
+
+		public:
+			builder();
+			builder(const s2::stringview& root);
+			builder(const builder&) = delete;
+			~builder();
+
+			builder& operator =(const builder&) = delete;
+
+			// Adds a component to the end of the path.
+			void push(const s2::stringview& component);
+
+			// Removes the last component that was pushed. Does nothing if there is nothing left to pop.
+			void pop();
+
+			// Removes all pushed components, leaving only the root.
+			void clear();
+
+			// The amount of components that were pushed and not popped.
+			inline size_t depth() const { return m_numMarks; }
+
+			inline const s2::string& str() const { return m_path; }
+			inline const char* c_str() const { return m_path.c_str(); }
+			inline size_t len() const { return m_path.len(); }
+			inline operator s2::stringview() const { return s2::stringview(m_path.c_str(), m_path.len()); }
+
+		private:
+			void truncate(size_t len);
+		};
+
 		// Returns true if the given 2 paths can be considered equal.
 		// - caseSensitive: Whether to test for case sensitivity.
 		bool equals(const s2::stringview& pathA, const s2::stringview& pathB, bool caseSensitive);
@@ -46,84 +100,195 @@ namespace s2
 		// Gets the file name of the given path without the extension. For example, `hello/world/foo.txt` will
 		// return `foo`.
 		s2::string getFileNameWithoutExtension(const s2::stringview& path);
+
+		// These work like the functions above, but return a view into the given path instead of allocating a new
+		// string.
+		s2::stringview getExtensionView(const s2::stringview& path);
+		s2::stringview getDirectoryNameView(const s2::stringview& path);
+		s2::stringview getFileNameView(const s2::stringview& path);
+
+		// Resolves `.` and `..` components and removes duplicate separators in a single pass. The result uses forward
+		// slashes, and keeps a leading and trailing slash if the path had one. A `..` that goes above the start of a
+		// relative path is kept, and one that goes above the root of an absolute path is dropped. For example,
+		// `foo/./bar//../baz` will return `foo/baz`, and a path that resolves to nothing will return `.`.
+		s2::string normalize(const s2::stringview& path);
 	}
+
+	// Iterates over the components of a path as views, without allocating anything. Both forward slashes and
+	// backslashes are separators, and empty components from leading, trailing or duplicate separators are skipped. For
+	// example, `/usr//lib/` gives `usr` and `lib`. The components are given as they are, so `.` and `..` are not
+	// resolved; use s2::path::normalize for that.
+	class pathview
+	{
+	public:
+		class iterator
+		{
+		private:
+			const char* m_token;
+			size_t m_tokenLen;
+			const char* m_end;
+
+		public:
+			inline iterator(const char* start, const char* end)
+				: m_token(start), m_tokenLen(0), m_end(end)
+			{
+				if (start != nullptr) {
+					operator ++();
+				}
+			}
+
+			inline bool operator ==(const iterator& other) const { return m_token == other.m_token; }
+			inline bool operator !=(const iterator& other) const { return m_token != other.m_token; }
+
+			inline iterator& operator ++()
+			{
+				const char* p = m_token + m_tokenLen;
+				while (p < m_end && (*p == '/' || *p == '\\')) {
+					p++;
+				}
+				if (p == m_end) {
+					m_token = nullptr;
+					m_tokenLen = 0;
+					return *this;
+				}
+
+				const char* end = p;
+				while (end < m_end && *end != '/' && *end != '\\') {
+					end++;
+				}
+				m_token = p;
+				m_tokenLen = end - p;
+				return *this;
+			}
+
+			inline stringview operator *() const { return stringview(m_token, m_tokenLen); }
+		};
+
+	private:
+		const char* m_str;
+		size_t m_len;
+
+	public:
+		inline pathview(const stringview& path)
+			: m_str(path.c_str()), m_len(path.len())
+		{
+		}
+
+		// Returns true if the path starts with a separator.
+		inline bool is_absolute() const { return m_len > 0 && (m_str[0] == '/' || m_str[0] == '\\'); }
+
+		// Returns true if the path ends with a separator.
+		inline bool is_directory() const { return m_len > 0 && (m_str[m_len - 1] == '/' || m_str[m_len - 1] == '\\'); }
+
+		// Counts the components by iterating over them.
+		inline size_t len() const
+		{
+			size_t ret = 0;
+			for (iterator it = begin(); it != end(); ++it) {
+				ret++;
+			}
+			return ret;
+		}
+
+		inline iterator begin() const { return iterator(m_str, m_str + m_len); }
+		inline iterator end() const { return iterator(nullptr, nullptr); }
+	};
 }
 
 #if defined(S2_IMPL)
 #include <cstring>
 #include <cctype>
 
-s2::string s2::path::getExtension(const s2::stringview& path)
+namespace s2
 {
-	const char* pStart = path.c_str();
-	const char* pEnd = pStart + path.len();
+	static inline bool path_is_separator(char c)
+	{
+		return c == '/' || c == '\\';
+	}
 
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
+	// Returns the last separator in the path, or nullptr if there is none. This only looks at the length of the view,
+	// so the path doesn't have to be null-terminated.
+	static inline const char* path_last_separator(const char* start, const char* end)
+	{
+		for (const char* p = end; p > start; p--) {
+			if (path_is_separator(p[-1])) {
+				return p - 1;
+			}
+		}
+		return nullptr;
 	}
 
-	const char* pPeriod = strrchr(pSlash != nullptr ? pSlash : pStart, '.');
+	// Returns the period that starts the extension of the file name between start and end, or nullptr if there is none.
+	static inline const char* path_extension_period(const char* start, const char* end)
+	{
+		return memrfind(start, end - start, '.');
+	}
 
-	if (pPeriod != nullptr) {
-		return s2::string(pPeriod, pEnd - pPeriod);
+	static inline const char* path_file_name_start(const char* start, const char* end)
+	{
+		const char* pSlash = path_last_separator(start, end);
+		return pSlash != nullptr ? pSlash + 1 : start;
+	}
+
+	// Appends a path to the end of another path, the same way as s2::path::join
+	static inline void path_append(s2::string& ret, const s2::stringview& path)
+	{
+		if (ret.len() == 0) {
+			ret.append(path);
+			return;
+		} else if (path.len() == 0) {
+			return;
+		}
+
+		const char ca = ret[(int)ret.len() - 1];
+		if (!path_is_separator(ca)) {
+			ret.append('/');
+		}
+
+		if (path_is_separator(path[0])) {
+			ret.append(path.c_str() + 1, path.len() - 1);
+		} else {
+			ret.append(path.c_str(), path.len());
+		}
 	}
-	return "";
+}
+
+s2::string s2::path::getExtension(const s2::stringview& path)
+{
+	s2::stringview ret = getExtensionView(path);
+	return s2::string(ret.c_str(), ret.len());
 }
 
 bool s2::path::hasExtension(const s2::stringview& path)
 {
 	const char* pStart = path.c_str();
-
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
-	}
-
-	return strrchr(pSlash != nullptr ? pSlash : pStart, '.') != nullptr;
+	const char* pEnd = pStart + path.len();
+	const char* pName = path_file_name_start(pStart, pEnd);
+	return path_extension_period(pName, pEnd) != nullptr;
 }
 
 s2::string s2::path::changeExtension(const s2::stringview& path, const s2::stringview& extension)
 {
 	const char* pStart = path.c_str();
 	const char* pEnd = pStart + path.len();
-
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
+	const char* pPeriod = path_extension_period(path_file_name_start(pStart, pEnd), pEnd);
+
+	// Skip over the period in the extension, since we either keep the one in the path or add our own
+	const char* pExtension = extension.c_str();
+	size_t extensionLen = extension.len();
+	if (extensionLen > 0 && pExtension[0] == '.') {
+		pExtension++;
+		extensionLen--;
 	}
 
-	const char* pPeriod = strrchr(pSlash != nullptr ? pSlash : pStart, '.');
+	// Keep everything up to and including the period of the old extension, or the entire path if there is none
+	size_t baseLen = pPeriod != nullptr ? (size_t)(pPeriod - pStart) : path.len();
 
 	s2::string ret;
-	if (pPeriod == nullptr) {
-		// There is no extension in the path, so we can add the entire thing w/o any extension and period here
-		ret.append(pStart, pEnd - pStart);
-
-		// Add a period if it's not already in the extension
-		if (extension.len() == 0 || extension[0] != '.') {
-			ret.append('.');
-		}
-
-		// Add the new extension
-		if (extension.len() > 0) {
-			ret.append(extension);
-		}
-	} else {
-		// There is an extension in the path, so add it here, including the period for the extension
-		ret.append(pStart, (pPeriod - pStart) + 1);
-
-		// We don't have to add the period, so skip over it if it's in the extension
-		if (extension.len() > 0 && extension[0] == '.') {
-			ret.append(extension.c_str() + 1, extension.len() - 1);
-		} else {
-			ret.append(extension);
-		}
-	}
-
+	ret.ensure_memory(baseLen + 1 + extensionLen + 1);
+	ret.append(pStart, baseLen);
+	ret.append('.');
+	ret.append(pExtension, extensionLen);
 	return ret;
 }
 
@@ -132,14 +297,7 @@ s2::string s2::path::removeExtension(const s2::stringview& path)
 	const char* pStart = path.c_str();
 	const char* pEnd = pStart + path.len();
 
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
-	}
-
-	const char* pPeriod = strrchr(pSlash != nullptr ? pSlash : pStart, '.');
-
+	const char* pPeriod = path_extension_period(path_file_name_start(pStart, pEnd), pEnd);
 	if (pPeriod == nullptr) {
 		// There is no extension in the path, so we can add the entire thing w/o any extension and period here
 		return s2::string(pStart, pEnd - pStart);
@@ -174,6 +332,72 @@ s2::string s2::path::join(const s2::stringview& pathA, const s2::stringview& pat
 	return ret;
 }
 
+s2::string s2::path::join(std::initializer_list<s2::stringview> paths)
+{
+	// Every path adds at most one separator
+	size_t len = 0;
+	for (const s2::stringview& path : paths) {
+		len += path.len() + 1;
+	}
+
+	s2::string ret;
+	if (len > paths.size()) {
+		ret.ensure_memory(len + 1);
+	}
+	for (const s2::stringview& path : paths) {
+		path_append(ret, path);
+	}
+	return ret;
+}
+
+s2::path::builder::builder()
+{
+}
+
+s2::path::builder::builder(const s2::stringview& root)
+	: m_path(root.c_str(), root.len()), m_rootLen(root.len())
+{
+}
+
+s2::path::builder::~builder()
+{
+	if (m_marks != nullptr) {
+		S2_FREE(m_marks);
+	}
+}
+
+void s2::path::builder::push(const s2::stringview& component)
+{
+	if (m_numMarks == m_marksCapacity) {
+		m_marksCapacity = m_marksCapacity == 0 ? 8 : m_marksCapacity * 2;
+		m_marks = (size_t*)S2_REALLOC(m_marks, m_marksCapacity * sizeof(size_t));
+	}
+	m_marks[m_numMarks++] = m_path.len();
+	path_append(m_path, component);
+}
+
+void s2::path::builder::pop()
+{
+	if (m_numMarks > 0) {
+		truncate(m_marks[--m_numMarks]);
+	}
+}
+
+void s2::path::builder::clear()
+{
+	m_numMarks = 0;
+	truncate(m_rootLen);
+}
+
+void s2::path::builder::truncate(size_t len)
+{
+	// Keep the buffer around for the next push
+	if (len < m_path.len()) {
+		((char*)m_path.c_str())[len] = '\0';
+		m_path.set_length_unsafe(len);
+	}
+}
+
 bool s2::path::equals(const s2::stringview& pathA, const s2::stringview& pathB, bool caseSensitive)
 {
 	if (pathA.len() != pathB.len()) {
@@ -206,58 +430,129 @@ bool s2::path::equals(const s2::stringview& pathA, const s2::stringview& pathB,
 
 s2::string s2::path::getDirectoryName(const s2::stringview& path)
 {
-	const char* pStart = path.c_str();
-	const char* pEnd = pStart + path.len();
+	s2::stringview ret = getDirectoryNameView(path);
+	return s2::string(ret.c_str(), ret.len());
+}
 
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
-	}
+s2::string s2::path::getFileName(const s2::stringview& path)
+{
+	s2::stringview ret = getFileNameView(path);
+	return s2::string(ret.c_str(), ret.len());
+}
 
-	if (pSlash != nullptr) {
-		return s2::string(pStart, pSlash - pStart + 1);
+s2::string s2::path::getFileNameWithoutExtension(const s2::stringview& path)
+{
+	const char* pEnd = path.c_str() + path.len();
+	const char* pName = path_file_name_start(path.c_str(), pEnd);
+
+	const char* pPeriod = path_extension_period(pName, pEnd);
+	if (pPeriod != nullptr) {
+		pEnd = pPeriod;
 	}
-	return "";
+	return s2::string(pName, pEnd - pName);
 }
 
-s2::string s2::path::getFileName(const s2::stringview& path)
+s2::stringview s2::path::getExtensionView(const s2::stringview& path)
 {
 	const char* pStart = path.c_str();
 	const char* pEnd = pStart + path.len();
 
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
+	const char* pPeriod = path_extension_period(path_file_name_start(pStart, pEnd), pEnd);
+	if (pPeriod != nullptr) {
+		return s2::stringview(pPeriod, pEnd - pPeriod);
 	}
+	return s2::stringview();
+}
+
+s2::stringview s2::path::getDirectoryNameView(const s2::stringview& path)
+{
+	const char* pStart = path.c_str();
 
+	const char* pSlash = path_last_separator(pStart, pStart + path.len());
 	if (pSlash != nullptr) {
-		return s2::string(pSlash + 1, pEnd - (pSlash + 1));
+		return s2::stringview(pStart, pSlash - pStart + 1);
 	}
-	return s2::string(path.c_str(), path.len());
+	return s2::stringview();
 }
 
-s2::string s2::path::getFileNameWithoutExtension(const s2::stringview& path)
+s2::stringview s2::path::getFileNameView(const s2::stringview& path)
 {
-	const char* pStart = path.c_str();
-	const char* pEnd = pStart + path.len();
+	const char* pEnd = path.c_str() + path.len();
+	const char* pName = path_file_name_start(path.c_str(), pEnd);
+	return s2::stringview(pName, pEnd - pName);
+}
 
-	const char* pSlash = strrchr(pStart, '/');
-	const char* pBackslash = strrchr(pStart, '\\');
-	if (pBackslash != nullptr && pBackslash > pSlash) {
-		pSlash = pBackslash;
+s2::string s2::path::normalize(const s2::stringview& path)
+{
+	const char* p = path.c_str();
+	const char* pEnd = p + path.len();
+	if (p == pEnd) {
+		return s2::string();
 	}
 
-	const char* pPeriod = strrchr(pSlash != nullptr ? pSlash : pStart, '.');
-	if (pPeriod != nullptr) {
-		pEnd = pPeriod;
+	// The result is never longer than the path, except for a path that resolves to nothing, which becomes "."
+	s2::string ret;
+	ret.ensure_memory(path.len() + 2);
+	char* out = (char*)ret.c_str();
+	size_t len = 0;
+
+	bool absolute = path_is_separator(*p);
+	if (absolute) {
+		out[len++] = '/';
 	}
+	// Components before this point are ".." that can't be resolved, so they are never removed
+	size_t root = len;
 
-	if (pSlash != nullptr) {
-		return s2::string(pSlash + 1, pEnd - (pSlash + 1));
+	while (p < pEnd) {
+		while (p < pEnd && path_is_separator(*p)) {
+			p++;
+		}
+		const char* pComponent = p;
+		while (p < pEnd && !path_is_separator(*p)) {
+			p++;
+		}
+		size_t componentLen = p - pComponent;
+
+		if (componentLen == 0 || (componentLen == 1 && pComponent[0] == '.')) {
+			continue;
+		}
+
+		if (componentLen == 2 && pComponent[0] == '.' && pComponent[1] == '.') {
+			if (len > root) {
+				// Remove the last component, along with the separator before it
+				while (len > root && out[len - 1] != '/') {
+					len--;
+				}
+				if (len > root) {
+					len--;
+				}
+				continue;
+			}
+			if (absolute) {
+				continue;
+			}
+		}
+
+		if (len > 0 && out[len - 1] != '/') {
+			out[len++] = '/';
+		}
+		memcpy(out + len, pComponent, componentLen);
+		len += componentLen;
+
+		if (componentLen == 2 && pComponent[0] == '.' && pComponent[1] == '.') {
+			root = len;
+		}
 	}
-	return s2::string(pStart, pEnd - pStart);
+
+	if (len == 0) {
+		out[len++] = '.';
+	} else if (path_is_separator(pEnd[-1]) && out[len - 1] != '/') {
+		out[len++] = '/';
+	}
+
+	out[len] = '\0';
+	ret.set_length_unsafe(len);
+	return ret;
 }
 
 #endif
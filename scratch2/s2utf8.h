@@ -0,0 +1,619 @@
+#pragma once
+
+#define S2_USING_UTF8
+
+#include "s2string.h"
+
+namespace s2
+{
+	// Returned by the transcoding functions when the input is not valid.
+	static constexpr size_t utf_error = (size_t)-1;
+
+	// The code point that invalid input is decoded as by utf8view.
+	static constexpr char32_t utf_replacement = 0xFFFD;
+
+	// Returns true if the buffer is valid UTF-8: no overlong encodings, no surrogates, nothing above U+10FFFF, and no
+	// truncated sequences. This uses AVX2 when available, and skips over ASCII 16 bytes at a time with SSE2.
+	bool utf8_validate(const char* str, size_t len);
+	inline bool utf8_validate(const stringview& str) { return utf8_validate(str.c_str(), str.len()); }
+
+	// Returns the amount of code points in valid UTF-8.
+	size_t utf8_length(const char* str, size_t len);
+	inline size_t utf8_length(const stringview& str) { return utf8_length(str.c_str(), str.len()); }
+
+	// Decodes a single code point at the start of the buffer. Returns the amount of bytes used, or 0 if the buffer does
+	// not start with a valid UTF-8 sequence.
+	size_t utf8_decode(const char* str, size_t len, char32_t& codepoint);
+
+	// Encodes a single code point into the buffer, which needs room for 4 bytes. Returns the amount of bytes written,
+	// or 0 if the code point is a surrogate or above U+10FFFF.
+	size_t utf8_encode(char* buffer, char32_t codepoint);
+
+	// These transcode between UTF-8, UTF-16 and UTF-32, returning the amount of units written to dst, or utf_error if
+	// the input is not valid. The destination must have room for at least:
+	// - utf8_to_utf16: len units
+	// - utf8_to_utf32: len units
+	// - utf16_to_utf8: len * 3 bytes
+	// - utf32_to_utf8: len * 4 bytes
+	size_t utf8_to_utf16(const char* src, size_t len, char16_t* dst);
+	size_t utf8_to_utf32(const char* src, size_t len, char32_t* dst);
+	size_t utf16_to_utf8(const char16_t* src, size_t len, char* dst);
+	size_t utf32_to_utf8(const char32_t* src, size_t len, char* dst);
+
+	// Returns the given UTF-16 or UTF-32 text as a UTF-8 string, or a null string if the input is not valid.
+	string utf16_to_string(const char16_t* src, size_t len);
+	string utf32_to_string(const char32_t* src, size_t len);
+
+	// Iterates over the code points of UTF-8 text. Invalid bytes are returned as utf_replacement, one at a time.
+	class utf8view
+	{
+	public:
+		class iterator
+		{
+		private:
+			const char* m_p;
+			const char* m_end;
+			char32_t m_codepoint = 0;
+			size_t m_size = 0;
+
+		public:
+			inline iterator(const char* p, const char* end)
+				: m_p(p), m_end(end)
+			{
+				decode();
+			}
+
+			inline char32_t operator *() const { return m_codepoint; }
+			inline bool operator !=(const iterator& other) const { return m_p != other.m_p; }
+			inline bool operator ==(const iterator& other) const { return m_p == other.m_p; }
+
+			inline iterator& operator ++()
+			{
+				m_p += m_size;
+				decode();
+				return *this;
+			}
+
+			// Returns a pointer to the start of the current code point
+			inline const char* ptr() const { return m_p; }
+
+		private:
+			inline void decode()
+			{
+				if (m_p == m_end) {
+					return;
+				}
+				if ((unsigned char)*m_p < 0x80) {
+					m_codepoint = (unsigned char)*m_p;
+					m_size = 1;
+					return;
+				}
+				m_size = utf8_decode(m_p, m_end - m_p, m_codepoint);
+				if (m_size == 0) {
+					m_codepoint = utf_replacement;
+					m_size = 1;
+				}
+			}
+		};
+
+	private:
+		const char* m_str;
+		size_t m_len;
+
+	public:
+		inline utf8view(const stringview& str) : m_str(str.c_str()), m_len(str.len()) {}
+		inline utf8view(const char* str, size_t len) : m_str(str), m_len(len) {}
+
+		inline iterator begin() const { return iterator(m_str, m_str + m_len); }
+		inline iterator end() const { return iterator(m_str + m_len, m_str + m_len); }
+	};
+}
+
+#if defined(S2_IMPL)
+namespace s2
+{
+	static inline bool utf8_is_ascii(unsigned char c)
+	{
+		return c < 0x80;
+	}
+
+	static inline int utf8_popcount(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		return (int)__popcnt(mask);
+#else
+		return __builtin_popcount(mask);
+#endif
+	}
+
+#if !defined(S2_STRING_SSE2)
+	static bool utf8_validate_scalar(const unsigned char* p, const unsigned char* end)
+	{
+		while (p < end) {
+			if (utf8_is_ascii(*p)) {
+				p++;
+				continue;
+			}
+			char32_t codepoint;
+			size_t size = utf8_decode((const char*)p, end - p, codepoint);
+			if (size == 0) {
+				return false;
+			}
+			p += size;
+		}
+		return true;
+	}
+#endif
+
+#if defined(S2_STRING_SSE2)
+	static inline bool utf8_block_is_ascii(const unsigned char* p)
+	{
+		return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)p)) == 0;
+	}
+
+	// Skips over ASCII a block at a time, and only decodes the code points in between one by one
+	static bool utf8_validate_sse2(const unsigned char* p, const unsigned char* end)
+	{
+		while (p < end) {
+			if (end - p >= 16 && utf8_block_is_ascii(p)) {
+				p += 16;
+				continue;
+			}
+			if (utf8_is_ascii(*p)) {
+				p++;
+				continue;
+			}
+			char32_t codepoint;
+			size_t size = utf8_decode((const char*)p, end - p, codepoint);
+			if (size == 0) {
+				return false;
+			}
+			p += size;
+		}
+		return true;
+	}
+
+	static size_t utf8_continuations_sse2(const unsigned char* p, size_t len, size_t& i)
+	{
+		// Continuation bytes are 0x80..0xBF, which are the signed values below -64
+		size_t ret = 0;
+		for (; i + 16 <= len; i += 16) {
+			__m128i block = _mm_loadu_si128((const __m128i*)(p + i));
+			ret += utf8_popcount((uint32_t)_mm_movemask_epi8(_mm_cmplt_epi8(block, _mm_set1_epi8(-64))));
+		}
+		return ret;
+	}
+#endif
+
+#if defined(S2_STRING_AVX2)
+	// Validation with the lookup algorithm from "Validating UTF-8 In Less Than One Instruction Per Byte" by John Keiser
+	// and Daniel Lemire. Each pair of adjacent bytes is classified with three 16-entry table lookups on their nibbles,
+	// and the bits that are set in all three lookups are errors. Only the checks for 3 and 4 byte sequences need to look
+	// further back.
+	enum
+	{
+		utf8_too_short = 1 << 0, // 11______ 0_______ or 11______ 11______
+		utf8_too_long = 1 << 1, // 0_______ 10______
+		utf8_overlong_3 = 1 << 2, // 11100000 100_____
+		utf8_too_large = 1 << 3, // 11110100 1001____ and above
+		utf8_surrogate = 1 << 4, // 11101101 101_____
+		utf8_overlong_2 = 1 << 5, // 1100000_ 10______
+		utf8_too_large_1000 = 1 << 6, // 11110101 1000____ and above
+		utf8_overlong_4 = 1 << 6, // 11110000 1000____
+		utf8_two_conts = 1 << 7, // 10______ 10______
+		utf8_carry = utf8_too_short | utf8_too_long | utf8_two_conts,
+	};
+
+	S2_TARGET_AVX2 static inline __m256i utf8_prev_avx2(__m256i input, __m256i prevInput, int n)
+	{
+		__m256i shifted = _mm256_permute2x128_si256(prevInput, input, 0x21);
+		switch (n) {
+		case 1: return _mm256_alignr_epi8(input, shifted, 15);
+		case 2: return _mm256_alignr_epi8(input, shifted, 14);
+		default: return _mm256_alignr_epi8(input, shifted, 13);
+		}
+	}
+
+	S2_TARGET_AVX2 static inline __m256i utf8_lookup_avx2(__m256i table, __m256i nibbles)
+	{
+		return _mm256_shuffle_epi8(table, nibbles);
+	}
+
+	S2_TARGET_AVX2 static inline __m256i utf8_check_block_avx2(__m256i input, __m256i prevInput)
+	{
+		const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+
+		const __m256i byte1HighTable = _mm256_setr_epi8(
+			utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+			utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+			utf8_two_conts, utf8_two_conts, utf8_two_conts, utf8_two_conts,
+			utf8_too_short | utf8_overlong_2,
+			utf8_too_short,
+			utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+			utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4,
+			utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+			utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+			utf8_two_conts, utf8_two_conts, utf8_two_conts, utf8_two_conts,
+			utf8_too_short | utf8_overlong_2,
+			utf8_too_short,
+			utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+			utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4
+		);
+
+		const __m256i byte1LowTable = _mm256_setr_epi8(
+			utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+			utf8_carry | utf8_overlong_2,
+			utf8_carry,
+			utf8_carry,
+			utf8_carry | utf8_too_large,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+			utf8_carry | utf8_overlong_2,
+			utf8_carry,
+			utf8_carry,
+			utf8_carry | utf8_too_large,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+			utf8_carry | utf8_too_large | utf8_too_large_1000,
+			utf8_carry | utf8_too_large | utf8_too_large_1000
+		);
+
+		const __m256i byte2HighTable = _mm256_setr_epi8(
+			utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+			utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large_1000 | utf8_overlong_4,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+			utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+			utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+			utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large_1000 | utf8_overlong_4,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_overlong_3 | utf8_too_large,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+			utf8_too_long | utf8_overlong_2 | utf8_two_conts | utf8_surrogate | utf8_too_large,
+			utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short
+		);
+
+		__m256i prev1 = utf8_prev_avx2(input, prevInput, 1);
+		__m256i byte1High = utf8_lookup_avx2(byte1HighTable, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibble));
+		__m256i byte1Low = utf8_lookup_avx2(byte1LowTable, _mm256_and_si256(prev1, lowNibble));
+		__m256i byte2High = utf8_lookup_avx2(byte2HighTable, _mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble));
+		__m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+		// The third and fourth bytes of 3 and 4 byte sequences must be continuations, which the lookup above flags as
+		// two continuations in a row. Flip that bit back exactly where it's expected.
+		__m256i prev2 = utf8_prev_avx2(input, prevInput, 2);
+		__m256i prev3 = utf8_prev_avx2(input, prevInput, 3);
+		__m256i isThirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+		__m256i isFourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+		__m256i must23 = _mm256_and_si256(_mm256_or_si256(isThirdByte, isFourthByte), _mm256_set1_epi8((char)0x80));
+		return _mm256_xor_si256(must23, special);
+	}
+
+	S2_TARGET_AVX2 static inline __m256i utf8_incomplete_avx2(__m256i input)
+	{
+		// Sequences that start in the last 3 bytes of the block and continue into the next one
+		const __m256i maxValue = _mm256_setr_epi8(
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+		);
+		return _mm256_subs_epu8(input, maxValue);
+	}
+
+	S2_TARGET_AVX2 static bool utf8_validate_avx2(const unsigned char* p, size_t len)
+	{
+		__m256i error = _mm256_setzero_si256();
+		__m256i prevInput = _mm256_setzero_si256();
+		__m256i prevIncomplete = _mm256_setzero_si256();
+
+		size_t i = 0;
+		for (;; i += 32) {
+			__m256i input;
+			bool last = i + 32 > len;
+			if (last) {
+				// The tail is padded with zeros, which also catches sequences that are cut off at the end
+				unsigned char buffer[32] = { 0 };
+				memcpy(buffer, p + i, len - i);
+				input = _mm256_loadu_si256((const __m256i*)buffer);
+			} else {
+				input = _mm256_loadu_si256((const __m256i*)(p + i));
+			}
+
+			if (_mm256_movemask_epi8(input) == 0) {
+				error = _mm256_or_si256(error, prevIncomplete);
+			} else {
+				error = _mm256_or_si256(error, utf8_check_block_avx2(input, prevInput));
+				prevIncomplete = utf8_incomplete_avx2(input);
+			}
+			prevInput = input;
+
+			if (last) {
+				break;
+			}
+		}
+
+		return _mm256_testz_si256(error, error) != 0;
+	}
+
+	S2_TARGET_AVX2 static size_t utf8_continuations_avx2(const unsigned char* p, size_t len, size_t& i)
+	{
+		size_t ret = 0;
+		for (; i + 32 <= len; i += 32) {
+			__m256i block = _mm256_loadu_si256((const __m256i*)(p + i));
+			ret += utf8_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-64), block)));
+		}
+		return ret;
+	}
+#endif
+}
+
+bool s2::utf8_validate(const char* str, size_t len)
+{
+	const unsigned char* p = (const unsigned char*)str;
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		return utf8_validate_avx2(p, len);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	return utf8_validate_sse2(p, p + len);
+#else
+	return utf8_validate_scalar(p, p + len);
+#endif
+}
+
+size_t s2::utf8_length(const char* str, size_t len)
+{
+	const unsigned char* p = (const unsigned char*)str;
+	size_t continuations = 0;
+	size_t i = 0;
+#if defined(S2_STRING_AVX2)
+	if (cpu_has_avx2()) {
+		continuations += utf8_continuations_avx2(p, len, i);
+	}
+#endif
+#if defined(S2_STRING_SSE2)
+	continuations += utf8_continuations_sse2(p, len, i);
+#endif
+	for (; i < len; i++) {
+		if ((p[i] & 0xC0) == 0x80) {
+			continuations++;
+		}
+	}
+	return len - continuations;
+}
+
+size_t s2::utf8_decode(const char* str, size_t len, char32_t& codepoint)
+{
+	if (len == 0) {
+		return 0;
+	}
+
+	const unsigned char* p = (const unsigned char*)str;
+	unsigned char c = p[0];
+	if (c < 0x80) {
+		codepoint = c;
+		return 1;
+	}
+
+	size_t size;
+	char32_t ret;
+	char32_t min;
+	if ((c & 0xE0) == 0xC0) {
+		size = 2;
+		ret = c & 0x1F;
+		min = 0x80;
+	} else if ((c & 0xF0) == 0xE0) {
+		size = 3;
+		ret = c & 0x0F;
+		min = 0x800;
+	} else if ((c & 0xF8) == 0xF0) {
+		size = 4;
+		ret = c & 0x07;
+		min = 0x10000;
+	} else {
+		return 0;
+	}
+
+	if (len < size) {
+		return 0;
+	}
+	for (size_t i = 1; i < size; i++) {
+		if ((p[i] & 0xC0) != 0x80) {
+			return 0;
+		}
+		ret = (ret << 6) | (p[i] & 0x3F);
+	}
+
+	// Reject overlong encodings, surrogates and code points that are too large
+	if (ret < min || (ret >= 0xD800 && ret <= 0xDFFF) || ret > 0x10FFFF) {
+		return 0;
+	}
+
+	codepoint = ret;
+	return size;
+}
+
+size_t s2::utf8_encode(char* buffer, char32_t codepoint)
+{
+	unsigned char* p = (unsigned char*)buffer;
+	if (codepoint < 0x80) {
+		p[0] = (unsigned char)codepoint;
+		return 1;
+	} else if (codepoint < 0x800) {
+		p[0] = (unsigned char)(0xC0 | (codepoint >> 6));
+		p[1] = (unsigned char)(0x80 | (codepoint & 0x3F));
+		return 2;
+	} else if (codepoint < 0x10000) {
+		if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+			return 0;
+		}
+		p[0] = (unsigned char)(0xE0 | (codepoint >> 12));
+		p[1] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+		p[2] = (unsigned char)(0x80 | (codepoint & 0x3F));
+		return 3;
+	} else if (codepoint <= 0x10FFFF) {
+		p[0] = (unsigned char)(0xF0 | (codepoint >> 18));
+		p[1] = (unsigned char)(0x80 | ((codepoint >> 12) & 0x3F));
+		p[2] = (unsigned char)(0x80 | ((codepoint >> 6) & 0x3F));
+		p[3] = (unsigned char)(0x80 | (codepoint & 0x3F));
+		return 4;
+	}
+	return 0;
+}
+
+size_t s2::utf8_to_utf16(const char* src, size_t len, char16_t* dst)
+{
+	size_t i = 0;
+	char16_t* out = dst;
+	while (i < len) {
+#if defined(S2_STRING_SSE2)
+		// Widen runs of ASCII 16 bytes at a time
+		if (len - i >= 16) {
+			__m128i block = _mm_loadu_si128((const __m128i*)(src + i));
+			if (_mm_movemask_epi8(block) == 0) {
+				__m128i zero = _mm_setzero_si128();
+				_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(block, zero));
+				_mm_storeu_si128((__m128i*)(out + 8), _mm_unpackhi_epi8(block, zero));
+				out += 16;
+				i += 16;
+				continue;
+			}
+		}
+#endif
+		char32_t codepoint;
+		size_t size = utf8_decode(src + i, len - i, codepoint);
+		if (size == 0) {
+			return utf_error;
+		}
+		i += size;
+
+		if (codepoint < 0x10000) {
+			*out++ = (char16_t)codepoint;
+		} else {
+			codepoint -= 0x10000;
+			*out++ = (char16_t)(0xD800 + (codepoint >> 10));
+			*out++ = (char16_t)(0xDC00 + (codepoint & 0x3FF));
+		}
+	}
+	return out - dst;
+}
+
+size_t s2::utf8_to_utf32(const char* src, size_t len, char32_t* dst)
+{
+	size_t i = 0;
+	char32_t* out = dst;
+	while (i < len) {
+#if defined(S2_STRING_SSE2)
+		if (len - i >= 16) {
+			__m128i block = _mm_loadu_si128((const __m128i*)(src + i));
+			if (_mm_movemask_epi8(block) == 0) {
+				__m128i zero = _mm_setzero_si128();
+				__m128i low = _mm_unpacklo_epi8(block, zero);
+				__m128i high = _mm_unpackhi_epi8(block, zero);
+				_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(low, zero));
+				_mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi16(low, zero));
+				_mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi16(high, zero));
+				_mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(high, zero));
+				out += 16;
+				i += 16;
+				continue;
+			}
+		}
+#endif
+		char32_t codepoint;
+		size_t size = utf8_decode(src + i, len - i, codepoint);
+		if (size == 0) {
+			return utf_error;
+		}
+		i += size;
+		*out++ = codepoint;
+	}
+	return out - dst;
+}
+
+size_t s2::utf16_to_utf8(const char16_t* src, size_t len, char* dst)
+{
+	char* out = dst;
+	for (size_t i = 0; i < len; i++) {
+		char32_t codepoint = src[i];
+		if (codepoint < 0x80) {
+			*out++ = (char)codepoint;
+			continue;
+		}
+
+		if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+			// A high surrogate must be followed by a low surrogate
+			if (i + 1 == len || src[i + 1] < 0xDC00 || src[i + 1] > 0xDFFF) {
+				return utf_error;
+			}
+			codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (src[i + 1] - 0xDC00);
+			i++;
+		} else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+			return utf_error;
+		}
+
+		out += utf8_encode(out, codepoint);
+	}
+	return out - dst;
+}
+
+size_t s2::utf32_to_utf8(const char32_t* src, size_t len, char* dst)
+{
+	char* out = dst;
+	for (size_t i = 0; i < len; i++) {
+		size_t size = utf8_encode(out, src[i]);
+		if (size == 0) {
+			return utf_error;
+		}
+		out += size;
+	}
+	return out - dst;
+}
+
+s2::string s2::utf16_to_string(const char16_t* src, size_t len)
+{
+	s2::string ret;
+	ret.ensure_memory(len * 3 + 1);
+	char* p = &ret[0];
+	size_t size = utf16_to_utf8(src, len, p);
+	if (size == utf_error) {
+		return s2::string();
+	}
+	p[size] = '\0';
+	ret.set_length_unsafe(size);
+	return ret;
+}
+
+s2::string s2::utf32_to_string(const char32_t* src, size_t len)
+{
+	s2::string ret;
+	ret.ensure_memory(len * 4 + 1);
+	char* p = &ret[0];
+	size_t size = utf32_to_utf8(src, len, p);
+	if (size == utf_error) {
+		return s2::string();
+	}
+	p[size] = '\0';
+	ret.set_length_unsafe(size);
+	return ret;
+}
+#endif
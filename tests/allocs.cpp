@@ -0,0 +1,17 @@
+#include "allocs.h"
+
+#include <cstdlib>
+
+int _numMallocs = 0;
+
+void* CountingMalloc(size_t size)
+{
+	_numMallocs++;
+	return malloc(size);
+}
+
+void* CountingRealloc(void* ptr, size_t size)
+{
+	_numMallocs++;
+	return realloc(ptr, size);
+}
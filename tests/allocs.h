@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+// The tests build all of scratch2 with these, so that they can check how many allocations something makes. This has to
+// be included before any of the scratch2 headers.
+extern int _numMallocs;
+
+void* CountingMalloc(size_t size);
+void* CountingRealloc(void* ptr, size_t size);
+
+#define S2_MALLOC(size) CountingMalloc(size)
+#define S2_REALLOC(ptr, size) CountingRealloc(ptr, size)
@@ -1,7 +1,17 @@
 #define S2_IMPL
 
+#include "allocs.h"
+
 #include <s2string.h>
 #include <s2stringpath.h>
+#include <s2stringbuilder.h>
+#include <s2format.h>
+#include <s2atom.h>
+#include <s2utf8.h>
+#include <s2sharedstring.h>
+#include <s2multisearch.h>
+#include <s2glob.h>
+#include <s2encoding.h>
 #include <s2list.h>
 #include <s2dict.h>
 #include <s2hashtable.h>
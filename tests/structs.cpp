@@ -1,8 +1,13 @@
 #include "structs.h"
 
+#include <cstdlib>
+
 int _numFooInstances = 0;
 int _numBarInstances = 0;
 
+int _numAllocations = 0;
+int _numLiveAllocations = 0;
+
 Foo::Foo()
 {
 	_numFooInstances++;
@@ -38,3 +43,27 @@ Bar::~Bar()
 {
 	_numBarInstances--;
 }
+
+void* CountingAllocator::allocate(size_t size)
+{
+	_numAllocations++;
+	_numLiveAllocations++;
+	return malloc(size);
+}
+
+void* CountingAllocator::reallocate(void* ptr, size_t size)
+{
+	_numAllocations++;
+	if (ptr == nullptr) {
+		_numLiveAllocations++;
+	}
+	return realloc(ptr, size);
+}
+
+void CountingAllocator::deallocate(void* ptr)
+{
+	if (ptr != nullptr) {
+		_numLiveAllocations--;
+	}
+	free(ptr);
+}
@@ -1,6 +1,11 @@
+#include <cstddef>
+
 extern int _numFooInstances;
 extern int _numBarInstances;
 
+extern int _numAllocations;
+extern int _numLiveAllocations;
+
 class Foo
 {
 public:
@@ -25,3 +30,11 @@ public:
 	Bar(const Bar &copy);
 	~Bar();
 };
+
+class CountingAllocator
+{
+public:
+	static void* allocate(size_t size);
+	static void* reallocate(void* ptr, size_t size);
+	static void deallocate(void* ptr);
+};
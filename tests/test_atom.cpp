@@ -0,0 +1,77 @@
+#include "allocs.h"
+
+#include <s2atom.h>
+#include <s2hashtable.h>
+
+#include <s2test.h>
+
+void test_atom()
+{
+	s2::test_group("atom");
+
+	s2::atompool pool;
+	S2_TEST(pool.len() == 0);
+	S2_TEST(pool.find("hello").is_null());
+
+	s2::atom hello = pool.intern("hello");
+	S2_TEST(!hello.is_null());
+	S2_TEST(pool.len() == 1);
+	S2_TEST(!strcmp(hello.c_str(), "hello"));
+	S2_TEST(hello.len() == 5);
+	S2_TEST(hello.view() == "hello");
+	S2_TEST(hello.hash() == s2::stringview("hello").hash());
+
+	// Interning the same text again gives the same atom, even from a slice of a larger buffer
+	s2::string strHello = "hello world";
+	S2_TEST(pool.intern(s2::stringview(strHello.c_str(), 5)) == hello);
+	S2_TEST(pool.find("hello") == hello);
+	S2_TEST(pool.len() == 1);
+
+	s2::atom world = pool.intern("world");
+	S2_TEST(world != hello);
+	S2_TEST(pool.len() == 2);
+
+	s2::atom empty = pool.intern("");
+	S2_TEST(!empty.is_null());
+	S2_TEST(empty.len() == 0);
+	S2_TEST(!strcmp(empty.c_str(), ""));
+	S2_TEST(empty != s2::atom());
+
+	// Lots of atoms, to make the index and the arena grow
+	s2::atom atoms[1000];
+	for (int i = 0; i < 1000; i++) {
+		atoms[i] = pool.intern(s2::strprintf("tag_%d", i));
+	}
+	S2_TEST(pool.len() == 1003);
+	bool atomsMatch = true;
+	for (int i = 0; i < 1000; i++) {
+		s2::string tag = s2::strprintf("tag_%d", i);
+		if (pool.intern(tag) != atoms[i] || pool.find(tag) != atoms[i] || atoms[i].view() != tag) {
+			atomsMatch = false;
+		}
+	}
+	S2_TEST(atomsMatch);
+	S2_TEST(pool.len() == 1003);
+	S2_TEST(pool.intern("hello") == hello);
+
+	// Text longer than a chunk
+	s2::string strLong;
+	for (int i = 0; i < 1000; i++) {
+		strLong.append("0123456789");
+	}
+	s2::atom atomLong = pool.intern(strLong);
+	S2_TEST(atomLong.view() == strLong);
+	S2_TEST(pool.intern(strLong) == atomLong);
+
+	// Atoms from the global pool
+	S2_TEST(s2::intern("global") == s2::intern("global"));
+	S2_TEST(s2::intern("global") != pool.intern("global"));
+
+	// Atoms as hashtable keys
+	s2::hashtable<s2::atom, int, s2::atomhasher> table;
+	table.add(hello) = 1;
+	table.add(world) = 2;
+	S2_TEST(table[hello] == 1);
+	S2_TEST(table[pool.intern("world")] == 2);
+	S2_TEST(table.contains(atoms[0]) == false);
+}
@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2cirbuf.h>
 
 #include <s2test.h>
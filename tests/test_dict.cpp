@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2dict.h>
 
 #include <s2test.h>
@@ -40,4 +42,17 @@ void test_dict()
 	}
 
 	S2_TEST(_numFooInstances == 0);
+
+	_numAllocations = 0;
+	{
+		s2::dict<int, int, CountingAllocator> dict_alloc;
+		dict_alloc[10] = 100;
+		dict_alloc[20] = 200;
+		S2_TEST(_numAllocations > 0);
+		S2_TEST(_numLiveAllocations == 1);
+		for (auto &pair : dict_alloc) {
+			S2_TEST(pair.value() == pair.key() * 10);
+		}
+	}
+	S2_TEST(_numLiveAllocations == 0);
 }
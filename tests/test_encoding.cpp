@@ -0,0 +1,172 @@
+#include "allocs.h"
+
+#include <s2encoding.h>
+#include <s2cirbuf.h>
+
+#include <s2test.h>
+
+struct encodingspan
+{
+	const char* buffer;
+	size_t size;
+};
+
+// Plain one-byte-at-a-time encoders, to compare the vectorized paths against
+static s2::string encoding_reference_base64(const uint8_t* p, size_t len)
+{
+	const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	s2::string ret;
+	for (size_t i = 0; i < len; i += 3) {
+		uint32_t v = (uint32_t)p[i] << 16;
+		if (i + 1 < len) v |= (uint32_t)p[i + 1] << 8;
+		if (i + 2 < len) v |= p[i + 2];
+		ret.append(chars[(v >> 18) & 63]);
+		ret.append(chars[(v >> 12) & 63]);
+		ret.append(i + 1 < len ? chars[(v >> 6) & 63] : '=');
+		ret.append(i + 2 < len ? chars[v & 63] : '=');
+	}
+	return ret;
+}
+
+static s2::string encoding_reference_hex(const uint8_t* p, size_t len, bool uppercase)
+{
+	const char* digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+	s2::string ret;
+	for (size_t i = 0; i < len; i++) {
+		ret.append(digits[p[i] >> 4]);
+		ret.append(digits[p[i] & 15]);
+	}
+	return ret;
+}
+
+void test_encoding()
+{
+	s2::test_group("encoding");
+
+	// Test vectors from RFC 4648
+	const char* plain[] = { "", "f", "fo", "foo", "foob", "fooba", "foobar" };
+	const char* base64[] = { "", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy" };
+	bool vectorsOk = true;
+	for (int i = 0; i < 7; i++) {
+		s2::string encoded;
+		s2::encode_base64(encoded, plain[i], strlen(plain[i]));
+		s2::string decoded;
+		vectorsOk = vectorsOk && encoded == base64[i];
+		vectorsOk = vectorsOk && s2::decode_base64(decoded, base64[i]) && decoded == plain[i];
+	}
+	S2_TEST(vectorsOk);
+
+	s2::string hex;
+	s2::encode_hex(hex, "\x01\xAB\xFF", 3);
+	S2_TEST(hex == "01abff");
+	s2::encode_hex(hex, "\x01\xAB\xFF", 3, true);
+	S2_TEST(hex == "01abff01ABFF");
+
+	s2::string bytes = "prefix:";
+	S2_TEST(s2::decode_hex(bytes, "4869"));
+	S2_TEST(bytes == "prefix:Hi");
+	S2_TEST(s2::decode_hex(bytes, "2C20") && bytes == "prefix:Hi, ");
+
+	// Invalid input leaves the string as it was
+	S2_TEST(!s2::decode_hex(bytes, "4"));
+	S2_TEST(!s2::decode_hex(bytes, "4g"));
+	S2_TEST(!s2::decode_hex(bytes, "48 9"));
+	S2_TEST(bytes == "prefix:Hi, ");
+
+	const char* invalidBase64[] = {
+		"Zg=", "Zg", "Z===", "====", "Zg==Zg==", "Zm9v=Zm9", "Zh==", "Zm9=", "Zm 9v", "Zm9v\n", "Zm9-", "Zm9_", "Zm\xC3\xA9",
+	};
+	bool invalidOk = true;
+	for (const char* input : invalidBase64) {
+		s2::string out = "x";
+		invalidOk = invalidOk && !s2::decode_base64(out, input) && out == "x";
+	}
+	S2_TEST(invalidOk);
+
+	// Buffer versions don't write a null terminator
+	char buffer[16];
+	memset(buffer, '#', sizeof(buffer));
+	S2_TEST(s2::encode_base64(buffer, "foo", 3) == 4);
+	S2_TEST(buffer[4] == '#');
+	S2_TEST(s2::decode_base64(buffer, "Zm9vYg==", 8) == 4);
+	S2_TEST(memcmp(buffer, "foob", 4) == 0);
+	S2_TEST(s2::decode_base64(buffer, "Zm9vYg=", 7) == s2::encoding_error);
+	S2_TEST(s2::decode_hex(buffer, "zz", 2) == s2::encoding_error);
+	S2_TEST(s2::base64_encoded_length(4) == 8);
+	S2_TEST(s2::base64_decoded_length(8) == 6);
+
+	// Random data of every length around the vector block sizes, with every alignment
+	uint8_t data[300];
+	uint32_t seed = 1234;
+	for (size_t i = 0; i < sizeof(data); i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (uint8_t)(seed >> 16);
+	}
+
+	bool roundtripOk = true;
+	for (size_t len = 0; len < 200; len++) {
+		const uint8_t* p = data + len % 7;
+
+		s2::string b64;
+		s2::encode_base64(b64, p, len);
+		roundtripOk = roundtripOk && b64 == encoding_reference_base64(p, len);
+
+		s2::string h;
+		s2::encode_hex(h, p, len, len % 2 == 0);
+		roundtripOk = roundtripOk && h == encoding_reference_hex(p, len, len % 2 == 0);
+
+		s2::string back;
+		roundtripOk = roundtripOk && s2::decode_base64(back, b64) && back.len() == len && memcmp(back.c_str(), p, len) == 0;
+		back = "";
+		roundtripOk = roundtripOk && s2::decode_hex(back, h) && back.len() == len && memcmp(back.c_str(), p, len) == 0;
+
+		// A single bad character anywhere must be caught, including inside blocks that are decoded with SIMD
+		if (len > 0) {
+			s2::string bad = b64;
+			((char*)bad.c_str())[(len * 7) % (b64.len() - 2)] = '*';
+			s2::string out;
+			roundtripOk = roundtripOk && !s2::decode_base64(out, bad) && out.len() == 0;
+
+			bad = h;
+			((char*)bad.c_str())[(len * 5) % h.len()] = (len % 2 == 0) ? 'G' : '/';
+			roundtripOk = roundtripOk && !s2::decode_hex(out, bad) && out.len() == 0;
+		}
+	}
+	S2_TEST(roundtripOk);
+
+	// Spans are treated as one continuous buffer, even when they split a block
+	s2::string full;
+	s2::encode_base64(full, data, 100);
+	encodingspan spans[] = { { (const char*)data, 10 }, { (const char*)data + 10, 1 }, { (const char*)data + 11, 89 } };
+	s2::string fromSpans;
+	s2::encode_base64_spans(fromSpans, spans);
+	S2_TEST(fromSpans == full);
+
+	encodingspan textSpans[] = { { full.c_str(), 5 }, { full.c_str() + 5, 0 }, { full.c_str() + 5, full.len() - 5 } };
+	s2::string decodedSpans;
+	S2_TEST(s2::decode_base64_spans(decodedSpans, textSpans));
+	S2_TEST(decodedSpans.len() == 100 && memcmp(decodedSpans.c_str(), data, 100) == 0);
+
+	encodingspan paddedSpans[] = { { "Zg==", 4 }, { "Zg==", 4 } };
+	s2::string padded = "x";
+	S2_TEST(!s2::decode_base64_spans(padded, paddedSpans));
+	S2_TEST(padded == "x");
+
+	s2::string hexFromSpans;
+	s2::encode_hex_spans(hexFromSpans, spans);
+	S2_TEST(hexFromSpans == encoding_reference_hex(data, 100, false));
+	encodingspan hexSpans[] = { { hexFromSpans.c_str(), 3 }, { hexFromSpans.c_str() + 3, hexFromSpans.len() - 3 } };
+	s2::string hexDecoded;
+	S2_TEST(s2::decode_hex_spans(hexDecoded, hexSpans));
+	S2_TEST(hexDecoded.len() == 100 && memcmp(hexDecoded.c_str(), data, 100) == 0);
+
+	// A circular buffer that wraps around gives a mapping with two spans
+	s2::cirbuf buf(64);
+	uint8_t skip[50];
+	buf.push(data, 50);
+	buf.take(skip, 50);
+	buf.push(data, 30);
+	s2::string fromCirbuf;
+	s2::encode_base64_spans(fromCirbuf, buf.peek_map(30));
+	S2_TEST(fromCirbuf == encoding_reference_base64(data, 30));
+}
@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2file.h>
 
 #include <s2test.h>
@@ -0,0 +1,53 @@
+#include "allocs.h"
+
+#include <s2format.h>
+
+#include <s2test.h>
+
+#include <cfloat>
+
+struct FormatWriter
+{
+	s2::string output;
+	int numWrites = 0;
+
+	void write(const void* buffer, size_t size)
+	{
+		output.append((const char*)buffer, size);
+		numWrites++;
+	}
+};
+
+void test_format()
+{
+	s2::test_group("format");
+
+	S2_TEST(s2::format(S2_FMT("")) == "");
+	S2_TEST(s2::format(S2_FMT("Hello")) == "Hello");
+	S2_TEST(s2::format(S2_FMT("{}"), "Hello") == "Hello");
+	S2_TEST(s2::format(S2_FMT("{}, {}!"), "Hello", "world") == "Hello, world!");
+	S2_TEST(s2::format(S2_FMT("{{}} {{{}}}"), 10) == "{} {10}");
+
+	s2::string name = "Nimble";
+	s2::stringview view("Quick brown", 5);
+	S2_TEST(s2::format(S2_FMT("{} and {}"), name, view) == "Nimble and Quick");
+
+	S2_TEST(s2::format(S2_FMT("{} {} {} {}"), 'x', true, false, (const char*)nullptr) == "x true false (null)");
+	S2_TEST(s2::format(S2_FMT("{} {} {} {}"), -1, 42u, INT64_MIN, UINT64_MAX) == "-1 42 -9223372036854775808 18446744073709551615");
+	S2_TEST(s2::format(S2_FMT("{} {} {}"), (short)-5, (unsigned char)200, (signed char)-100) == "-5 200 -100");
+	S2_TEST(s2::format(S2_FMT("{} {} {}"), 0.1, -2.5f, 1e100) == "0.1 -2.5 1e+100");
+	S2_TEST(s2::format(S2_FMT("{} {} {} {}"), 0.1f, 1.0f / 3.0f, 16777216.0f, FLT_MAX) == "0.1 0.33333334 16777216 3.4028235e+38");
+
+	// Appending to an existing string
+	s2::string str = "Values:";
+	for (int i = 0; i < 3; i++) {
+		s2::format_to(str, S2_FMT(" {}={}"), i, i * 1.5);
+	}
+	S2_TEST(str == "Values: 0=0 1=1.5 2=3");
+
+	// Writing to a writer, one write for each piece
+	FormatWriter writer;
+	s2::format_to(writer, S2_FMT("[{}] {}\n"), 123, name);
+	S2_TEST(writer.output == "[123] Nimble\n");
+	S2_TEST(writer.numWrites == 5);
+}
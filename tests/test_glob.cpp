@@ -0,0 +1,161 @@
+#include "allocs.h"
+
+#include <s2glob.h>
+#include <s2list.h>
+
+#include <s2test.h>
+
+// A straightforward recursive matcher for patterns with single stars, to compare the compiled matcher against
+static bool glob_reference(const char* p, const char* pEnd, const char* t, const char* tEnd, bool caseSensitive)
+{
+	auto isSep = [](char c) { return c == '/' || c == '\\'; };
+	auto fold = [caseSensitive](char c) {
+		if (c == '\\') {
+			return '/';
+		}
+		if (!caseSensitive && c >= 'A' && c <= 'Z') {
+			return (char)(c + ('a' - 'A'));
+		}
+		return c;
+	};
+
+	if (p == pEnd) {
+		return t == tEnd;
+	}
+	if (*p == '*') {
+		for (const char* s = t; ; s++) {
+			if (glob_reference(p + 1, pEnd, s, tEnd, caseSensitive)) {
+				return true;
+			}
+			if (s == tEnd || isSep(*s)) {
+				return false;
+			}
+		}
+	}
+	if (t == tEnd) {
+		return false;
+	}
+	if (*p == '?') {
+		return !isSep(*t) && glob_reference(p + 1, pEnd, t + 1, tEnd, caseSensitive);
+	}
+	return fold(*p) == fold(*t) && glob_reference(p + 1, pEnd, t + 1, tEnd, caseSensitive);
+}
+
+void test_glob()
+{
+	s2::test_group("glob");
+
+	s2::glob logs("logs/**/*.gz");
+	S2_TEST(logs.matches("logs/a.gz"));
+	S2_TEST(logs.matches("logs/2024/01/a.gz"));
+	S2_TEST(logs.matches("logs\\2024\\a.gz"));
+	S2_TEST(!logs.matches("logs/a.gzip"));
+	S2_TEST(!logs.matches("logsa.gz"));
+	S2_TEST(!logs.matches("other/logs/a.gz"));
+	S2_TEST(!logs.matches("logs/2024x/"));
+	S2_TEST(!logs.matches("Logs/a.gz"));
+	S2_TEST(logs.pattern() == "logs/**/*.gz");
+
+	S2_TEST(s2::glob::match("*.txt", "hello.txt"));
+	S2_TEST(s2::glob::match("*.txt", ".txt"));
+	S2_TEST(!s2::glob::match("*.txt", "dir/hello.txt"));
+	S2_TEST(s2::glob::match("*/*.txt", "dir/hello.txt"));
+	S2_TEST(s2::glob::match("**/*.txt", "hello.txt"));
+	S2_TEST(s2::glob::match("**/*.txt", "a/b/c/hello.txt"));
+	S2_TEST(s2::glob::match("**", "a/b/c"));
+	S2_TEST(s2::glob::match("**", ""));
+	S2_TEST(s2::glob::match("build/**", "build/obj/main.o"));
+	S2_TEST(!s2::glob::match("build/**", "builds/main.o"));
+	S2_TEST(s2::glob::match("a**b", "axxb"));
+	S2_TEST(!s2::glob::match("a**b", "ax/xb"));
+	S2_TEST(s2::glob::match("a/**/b", "a/b"));
+	S2_TEST(s2::glob::match("a/**/b", "a/x/y/b"));
+	S2_TEST(!s2::glob::match("a/**/b", "a/xb"));
+	S2_TEST(!s2::glob::match("**/a.gz", "xa.gz"));
+	S2_TEST(!s2::glob::match("logs/**/x.gz", "logs/abcx.gz"));
+	S2_TEST(!s2::glob::match("logs/**/x.gz", "logs/a/bx.gz"));
+
+	S2_TEST(s2::glob::match("file?.c", "file1.c"));
+	S2_TEST(!s2::glob::match("file?.c", "file.c"));
+	S2_TEST(!s2::glob::match("a?b", "a/b"));
+
+	S2_TEST(s2::glob::match("[abc].txt", "b.txt"));
+	S2_TEST(!s2::glob::match("[abc].txt", "d.txt"));
+	S2_TEST(s2::glob::match("[a-c][0-9]", "c7"));
+	S2_TEST(s2::glob::match("[!a-c]x", "dx"));
+	S2_TEST(s2::glob::match("[^a-c]x", "dx"));
+	S2_TEST(!s2::glob::match("[!a-c]x", "bx"));
+	S2_TEST(!s2::glob::match("a[!b]c", "a/c"));
+	S2_TEST(s2::glob::match("[]]", "]"));
+	S2_TEST(s2::glob::match("[", "["));
+	S2_TEST(s2::glob::match("a[b", "a[b"));
+
+	S2_TEST(s2::glob::match("Hello/*.TXT", "hello\\world.txt", false));
+	S2_TEST(s2::glob::match("[A-C]", "b", false));
+	S2_TEST(!s2::glob::match("[A-C]", "b", true));
+
+	S2_TEST(s2::glob::match("exact/path", "exact\\path"));
+	S2_TEST(!s2::glob::match("exact/path", "exact/path2"));
+	S2_TEST(s2::glob::match("", ""));
+	S2_TEST(!s2::glob::match("", "a"));
+
+	// Long patterns use more than one word of states
+	s2::string longPattern;
+	s2::string longText;
+	for (int i = 0; i < 50; i++) {
+		longPattern.append("*?x");
+		longText.append("abx");
+	}
+	s2::glob longGlob(longPattern);
+	S2_TEST(longGlob.matches(longText));
+	longText.append("y");
+	S2_TEST(!longGlob.matches(longText));
+	// Where skipping a "**/" crosses into the next word
+	s2::string dirPattern;
+	s2::string dirText;
+	for (int i = 0; i < 40; i++) {
+		dirPattern.append("a/**/");
+		dirText.append("a/");
+	}
+	dirPattern.append("b");
+	s2::glob dirGlob(dirPattern);
+	S2_TEST(dirGlob.matches(s2::strprintf("%sb", dirText.c_str())));
+	S2_TEST(dirGlob.matches(s2::strprintf("%sx/y/b", dirText.c_str())));
+	S2_TEST(!dirGlob.matches(s2::strprintf("%sxb", dirText.c_str())));
+	// Patterns with more than 512 tokens
+	s2::string hugePattern;
+	s2::string hugeText;
+	for (int i = 0; i < 600; i++) {
+		hugePattern.append(i % 2 == 0 ? "?" : "*");
+		hugeText.append("ab");
+	}
+	s2::glob hugeGlob("*");
+	hugeGlob = s2::glob(hugePattern);
+	S2_TEST(hugeGlob.matches(hugeText));
+	S2_TEST(!hugeGlob.matches("short"));
+
+	// Globs can be copied and kept in lists
+	s2::list<s2::glob> filters;
+	filters.add(s2::glob("*.h"));
+	filters.add(s2::glob("src/**/*.cpp"));
+	S2_TEST(filters[1].matches("src/a/b.cpp"));
+	s2::glob copy = filters[0];
+	S2_TEST(copy.matches("s2glob.h"));
+
+	// Compare patterns with single stars against a simple recursive matcher
+	const char* patterns[] = { "*", "a*", "*a", "a*b", "*a*", "?*?", "a/*", "*/b", "a*/*b", "*.*", "a?b*" };
+	const char* texts[] = { "", "a", "b", "ab", "ba", "aab", "a/b", "a\\b", "ab/ab", "x.y", "a.b.c", "A", "aXb", "a/", "/b" };
+	bool allOk = true;
+	for (const char* pattern : patterns) {
+		for (int cs = 0; cs < 2; cs++) {
+			s2::glob g(pattern, cs == 1);
+			for (const char* text : texts) {
+				bool expected = glob_reference(pattern, pattern + strlen(pattern), text, text + strlen(text), cs == 1);
+				if (g.matches(text) != expected) {
+					allOk = false;
+				}
+			}
+		}
+	}
+	S2_TEST(allOk);
+}
@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2hashtable.h>
 
 #include <s2test.h>
@@ -39,6 +41,26 @@ void test_hashtable()
 	dict.clear();
 	S2_TEST(dict.len() == 0);
 
+	// Compile time hashes must match the runtime hashes for every length of tail
+	using namespace s2::literals;
+	static_assert("foo"_s2h == s2::hash_string("foo"), "");
+	const char* hashKeys[] = { "", "a", "seven77", "eight888", "nine99999", "A much longer key with \xC3\xA9 in it" };
+	for (auto key : hashKeys) {
+		S2_TEST(s2::hash_string(key) == s2::default_hashers_hashtable::hash(key));
+	}
+
+	dict["foo"] = "FOO";
+	dict["config.timeout"] = "30";
+	constexpr uint64_t timeoutHash = "config.timeout"_s2h;
+	s2::string value;
+	S2_TEST(dict.index_of_prehashed(timeoutHash) == dict.index_of("config.timeout"));
+	S2_TEST(dict.contains_prehashed("foo"_s2h));
+	S2_TEST(!dict.contains_prehashed("bar"_s2h));
+	S2_TEST(dict.get_prehashed(timeoutHash, value));
+	S2_TEST(value == "30");
+	S2_TEST(!dict.get_prehashed("config.retries"_s2h, value));
+	dict.clear();
+
 	{
 		s2::hashtable<int, Foo> dict_foo;
 		S2_TEST(_numFooInstances == 0);
@@ -61,4 +83,15 @@ void test_hashtable()
 	S2_TEST(dict_unsorted.at(0).hash() == 10);
 	dict_unsorted.sort();
 	S2_TEST(dict_unsorted.at(0).hash() == 5);
+
+	_numAllocations = 0;
+	{
+		s2::hashtable<int, int, s2::default_hashers_hashtable, CountingAllocator> dict_alloc;
+		dict_alloc.add(10) = 100;
+		dict_alloc.add(20) = 200;
+		S2_TEST(_numAllocations > 0);
+		S2_TEST(_numLiveAllocations == 1);
+		S2_TEST(dict_alloc[20] == 200);
+	}
+	S2_TEST(_numLiveAllocations == 0);
 }
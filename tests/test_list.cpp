@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2list.h>
 
 #include <s2test.h>
@@ -127,4 +129,27 @@ void test_list()
 	arr.insert(6, 400);
 	S2_TEST(arr[5] == 3);
 	S2_TEST(arr[6] == 400);
+
+	s2::list<int> sortArr = { 30, 10, 20, 10 };
+	sortArr.sort();
+	S2_TEST(sortArr[0] == 10 && sortArr[1] == 10 && sortArr[2] == 20 && sortArr[3] == 30);
+
+	_numAllocations = 0;
+	{
+		s2::list<int, CountingAllocator> alloc_arr;
+		S2_TEST(_numAllocations == 0);
+		alloc_arr.add(1);
+		alloc_arr.add(2);
+		alloc_arr.add(3);
+		S2_TEST(_numAllocations > 0);
+		S2_TEST(_numLiveAllocations == 1);
+		S2_TEST(alloc_arr[2] == 3);
+
+		s2::list<int, CountingAllocator> alloc_arr2(alloc_arr);
+		S2_TEST(_numLiveAllocations == 2);
+		for (int num : alloc_arr2) {
+			S2_TEST(num > 0);
+		}
+	}
+	S2_TEST(_numLiveAllocations == 0);
 }
@@ -0,0 +1,150 @@
+#include "allocs.h"
+
+#include <s2multisearch.h>
+#include <s2list.h>
+
+#include <s2test.h>
+
+#include <cstdio>
+
+static bool multisearch_matches_at(const s2::stringview& text, size_t pos, const s2::stringview& pattern, bool nocase)
+{
+	if (pattern.len() == 0 || pattern.len() > text.len() - pos) {
+		return false;
+	}
+	for (size_t i = 0; i < pattern.len(); i++) {
+		char a = text.c_str()[pos + i];
+		char b = pattern.c_str()[i];
+		if (nocase && a >= 'A' && a <= 'Z') {
+			a += 'a' - 'A';
+		}
+		if (nocase && b >= 'A' && b <= 'Z') {
+			b += 'a' - 'A';
+		}
+		if (a != b) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Compares all searches against checking every pattern at every position
+static bool multisearch_check(const s2::list<s2::string>& patterns, const s2::stringview& text, bool nocase)
+{
+	s2::multisearch search(patterns, nocase);
+
+	size_t expectedCount = 0;
+	bool expectedFirst = false;
+	s2::multisearchmatch first = { 0, 0, 0 };
+	for (size_t pos = 0; pos < text.len(); pos++) {
+		for (size_t i = 0; i < patterns.len(); i++) {
+			if (multisearch_matches_at(text, pos, patterns[i], nocase)) {
+				if (!expectedFirst) {
+					first = { i, pos, patterns[i].len() };
+					expectedFirst = true;
+				}
+				expectedCount++;
+			}
+		}
+	}
+
+	bool ok = true;
+	size_t count = 0;
+	search.find_all(text, [&](const s2::multisearchmatch& match) {
+		count++;
+		if (match.pattern >= patterns.len() || match.len != patterns[match.pattern].len()) {
+			ok = false;
+		} else if (!multisearch_matches_at(text, match.pos, patterns[match.pattern], nocase)) {
+			ok = false;
+		}
+	});
+
+	s2::multisearchmatch match;
+	bool foundFirst = search.find_first(text, match);
+	if (foundFirst != expectedFirst) {
+		ok = false;
+	} else if (foundFirst && (match.pattern != first.pattern || match.pos != first.pos || match.len != first.len)) {
+		ok = false;
+	}
+
+	return ok && count == expectedCount && search.count(text) == expectedCount && search.contains_any(text) == expectedFirst;
+}
+
+void test_multisearch()
+{
+	s2::test_group("multisearch");
+
+	s2::multisearch search = { "error", "warn", "fatal" };
+	S2_TEST(search.len() == 3);
+	S2_TEST(search.pattern(1) == "warn");
+	S2_TEST(search.contains_any("2024-01-01 [fatal] disk full"));
+	S2_TEST(!search.contains_any("2024-01-01 [info] all good"));
+	S2_TEST(!search.contains_any("Error"));
+	S2_TEST(search.count("warn error warning") == 3);
+
+	s2::multisearchmatch match;
+	S2_TEST(search.find_first("a warning, then an error", match));
+	S2_TEST(match.pattern == 1 && match.pos == 2 && match.len == 4);
+	S2_TEST(!search.find_first("", match));
+
+	s2::multisearch searchNocase({ "error", "WARN" }, true);
+	S2_TEST(searchNocase.contains_any("an ERROR occurred"));
+	S2_TEST(searchNocase.count("Warn wArN warn") == 3);
+
+	// Overlapping and duplicate patterns are all reported
+	s2::multisearch overlapping = { "he", "she", "hers", "his", "she" };
+	S2_TEST(overlapping.count("ushers") == 4);
+
+	// Larger sets use an automaton, which should give the same results as small sets
+	s2::list<s2::string> keywords;
+	for (int i = 0; i < 200; i++) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "key%d", i * 7);
+		keywords.add(buffer);
+	}
+	s2::multisearch large(keywords);
+	S2_TEST(large.len() == 200);
+	S2_TEST(large.contains_any("value=KEY1 key14"));
+	S2_TEST(!large.contains_any("key1 key2 key3"));
+	S2_TEST(large.find_first("xkey1393", match));
+	S2_TEST(match.pos == 1 && match.len == 7 && large.pattern(match.pattern) == "key1393");
+
+	// A longer match that starts earlier, but ends later, is still the first match
+	s2::list<s2::string> nested = { "bcd", "abcdefghi", "x", "y", "z", "q", "r", "s", "t", "u" };
+	S2_TEST(multisearch_check(nested, "__abcdefghi__", false));
+
+	s2::list<s2::string> small = { "ab", "b", "abc", "ca", "Zz", "ab" };
+	s2::list<s2::string> big = small;
+	for (int i = 0; i < 20; i++) {
+		big.add(s2::string("c") + s2::string(i % 2 == 0 ? "ab" : "BA").substr(0, 1 + i % 2));
+		big.add(s2::string("q") + (char)('a' + i));
+	}
+	big.add("\xC3\xA9\xFF");
+
+	// Random texts over a small alphabet, so that there are plenty of matches
+	const char alphabet[] = "abcABCzZq\xC3\xA9\xFF";
+	uint32_t seed = 12345;
+	bool allOk = true;
+	for (int n = 0; n < 300; n++) {
+		char text[80];
+		size_t len = n % 80;
+		for (size_t i = 0; i < len; i++) {
+			seed = seed * 1103515245 + 12345;
+			text[i] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+		}
+		s2::stringview view(text, len);
+		allOk = allOk && multisearch_check(small, view, false) && multisearch_check(small, view, true);
+		allOk = allOk && multisearch_check(big, view, false) && multisearch_check(big, view, true);
+	}
+	S2_TEST(allOk);
+
+	// Patterns can be added one by one, and then compiled
+	s2::multisearch manual;
+	manual.add("needle");
+	manual.add("");
+	manual.compile();
+	S2_TEST(manual.len() == 2);
+	S2_TEST(manual.find_first("haystack with a needle", match));
+	S2_TEST(match.pattern == 0 && match.pos == 16);
+	S2_TEST(manual.count("") == 0);
+}
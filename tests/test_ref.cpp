@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2ref.h>
 
 #include <s2test.h>
@@ -1,8 +1,11 @@
+#include "allocs.h"
+
 #include <s2set.h>
 
 #include <s2test.h>
 
 #include <s2string.h>
+#include "structs.h"
 
 void test_set()
 {
@@ -21,9 +24,25 @@ void test_set()
 	S2_TEST(!set.contains("hello"));
 	S2_TEST(set.contains("world"));
 	S2_TEST(set.index_of("world") == 0);
+	using namespace s2::literals;
+	S2_TEST(set.index_of_prehashed("world"_s2h) == 0);
+	S2_TEST(set.contains_prehashed("world"_s2h));
+	S2_TEST(!set.contains_prehashed("hello"_s2h));
+	S2_TEST(s2::hash_string("hello world") == s2::default_hashers_set::hash("hello world"));
 
 	set.clear();
 	S2_TEST(set.len() == 0);
 	S2_TEST(!set.contains("world"));
 	S2_TEST(set.index_of("world") == -1);
+
+	_numAllocations = 0;
+	{
+		s2::set<int, s2::default_hashers_set, CountingAllocator> set_alloc;
+		set_alloc.add(10);
+		set_alloc.add(20);
+		S2_TEST(_numAllocations > 0);
+		S2_TEST(_numLiveAllocations == 1);
+		S2_TEST(set_alloc.contains(20));
+	}
+	S2_TEST(_numLiveAllocations == 0);
 }
@@ -0,0 +1,90 @@
+#include "allocs.h"
+
+#include <s2sharedstring.h>
+#include <s2list.h>
+
+#include <s2test.h>
+
+void test_sharedstring()
+{
+	s2::test_group("sharedstring");
+
+	s2::sharedstring strNull;
+	S2_TEST(strNull.is_null());
+	S2_TEST(strNull.len() == 0);
+	S2_TEST(strNull == "");
+	S2_TEST(strNull.count() == 0);
+
+	s2::sharedstring str = "Hello, world";
+	S2_TEST(!str.is_null());
+	S2_TEST(str == "Hello, world");
+	S2_TEST(str.len() == 12);
+	S2_TEST(str.count() == 1);
+
+	// Copies share the same buffer
+	s2::sharedstring copy = str;
+	S2_TEST(copy.c_str() == str.c_str());
+	S2_TEST(str.count() == 2);
+	S2_TEST(copy == str);
+
+	{
+		s2::list<s2::sharedstring> queue;
+		for (int i = 0; i < 10; i++) {
+			queue.add(str);
+		}
+		s2::list<s2::sharedstring> queueCopy = queue;
+		S2_TEST(str.count() == 22);
+		S2_TEST(queueCopy[9].c_str() == str.c_str());
+	}
+	S2_TEST(str.count() == 2);
+
+	// Moving doesn't touch the count
+	s2::sharedstring moved = static_cast<s2::sharedstring&&>(copy);
+	S2_TEST(copy.is_null());
+	S2_TEST(str.count() == 2);
+	S2_TEST(moved.c_str() == str.c_str());
+
+	// Changing a shared string detaches it from the others
+	moved.append("!");
+	S2_TEST(moved == "Hello, world!");
+	S2_TEST(str == "Hello, world");
+	S2_TEST(str.count() == 1);
+	S2_TEST(moved.count() == 1);
+	S2_TEST(moved != str);
+
+	s2::sharedstring other = str;
+	char* p = other.detach();
+	p[0] = 'J';
+	S2_TEST(other == "Jello, world");
+	S2_TEST(str == "Hello, world");
+	S2_TEST(other.count() == 1);
+
+	// A string that isn't shared keeps its buffer when detaching
+	const char* before = other.c_str();
+	S2_TEST(other.detach() == before);
+
+	s2::stringview view = str;
+	S2_TEST(view.len() == 12);
+	S2_TEST(view.c_str() == str.c_str());
+	S2_TEST(str.to_string() == "Hello, world");
+	S2_TEST(s2::sharedstring(s2::stringview("abcdef", 3)) == "abc");
+
+	other = str;
+	S2_TEST(other.c_str() == str.c_str());
+	S2_TEST(str.count() == 2);
+	other = "different";
+	S2_TEST(str.count() == 1);
+	S2_TEST(other == "different");
+
+	// Appending or assigning text from the string's own buffer
+	s2::sharedstring self = "a string that is appended to itself";
+	self.append(self.c_str(), self.len());
+	S2_TEST(self == "a string that is appended to itselfa string that is appended to itself");
+	s2::sharedstring selfCopy = self;
+	self.append(self.view());
+	S2_TEST(self.len() == 140);
+	S2_TEST(selfCopy.len() == 70);
+	self = self.c_str() + 105;
+	S2_TEST(self == "a string that is appended to itself");
+	S2_TEST(self.count() == 1);
+}
@@ -1,4 +1,12 @@
+#include "allocs.h"
+
 #include <s2string.h>
+#include <s2hashtable.h>
+#include <s2list.h>
+
+#include <cctype>
+#include <cfloat>
+#include <cstdio>
 
 #include <s2test.h>
 
@@ -110,6 +118,42 @@ void test_string()
 	s2::stringsplit parse8("", true);
 	S2_TEST(parse8.len() == 0);
 
+	// split_view should give the exact same tokens as stringsplit
+	const char* splitInputs[] = { "Test 10 20 30", "this is a test", "a;b;c;", ";a;b;c", "", ".", "a, b, c", "a,,b" };
+	const char* splitDelims[] = { " ", ";", ".", ", ", "," };
+	bool splitMatches = true;
+	for (const char* input : splitInputs) {
+		for (const char* delim : splitDelims) {
+			for (int limit = 0; limit < 4; limit++) {
+				s2::stringsplit expect(input, delim, limit);
+				size_t index = 0;
+				for (s2::stringview token : s2::stringview(input).split_view(delim, limit)) {
+					if (index >= expect.len() || s2::string(token.c_str(), token.len()) != expect[index]) {
+						splitMatches = false;
+					}
+					index++;
+				}
+				if (index != expect.len()) {
+					splitMatches = false;
+				}
+			}
+		}
+	}
+	S2_TEST(splitMatches);
+
+	s2::string strSplit = "key=value=more";
+	s2::splitview splitKeyValue = strSplit.split_view("=", 2);
+	S2_TEST(splitKeyValue.len() == 2);
+	auto itSplit = splitKeyValue.begin();
+	S2_TEST((*itSplit).len() == 3);
+	S2_TEST(!strncmp((*itSplit).c_str(), "key", 3));
+	++itSplit;
+	S2_TEST(*itSplit == "value=more");
+	++itSplit;
+	S2_TEST(itSplit == splitKeyValue.end());
+	S2_TEST(s2::string().split_view(",").len() == 0);
+	S2_TEST(strSplit.split_view("").len() == 0);
+
 	str = "   \t\t foo\tbar\n\n  \r\n";
 	S2_TEST(str.trim() == "foo\tbar");
 	str = "   \t\t foo\tbar";
@@ -118,6 +162,47 @@ void test_string()
 	S2_TEST(str.trim() == "foo\tbar");
 	str = "foo\tbar";
 	S2_TEST(str.trim() == "foo\tbar");
+	S2_TEST(s2::string("  \t  ").trim() == "");
+	S2_TEST(s2::string().trim().is_null());
+
+	// Trimming without allocating
+	str = "  \t key = value \r\n";
+	s2::stringview trimmed = str.trim_view();
+	S2_TEST(trimmed == "key = value");
+	S2_TEST(trimmed.c_str() == str.c_str() + 4);
+	S2_TEST(str.trim_view(" \t\r\nk") == "ey = value");
+	S2_TEST(s2::string().trim_view().len() == 0);
+	str.trim_inplace();
+	S2_TEST(str == "key = value");
+	S2_TEST(str.len() == 11);
+	str.trim_inplace("keu");
+	S2_TEST(str == "y = val");
+	str = " \n ";
+	str.trim_inplace();
+	S2_TEST(str == "");
+	S2_TEST(str.len() == 0);
+
+	// Character sets
+	constexpr s2::charset csvChars(",;");
+	static_assert(csvChars.contains(';') && !csvChars.contains(' '), "");
+	s2::charset highChars;
+	highChars.add('\xFF');
+	S2_TEST(highChars.contains('\xFF') && !highChars.contains('\x7F') && !highChars.contains('\0'));
+	S2_TEST(s2::charset().is_empty());
+	S2_TEST(s2::string("a,b;c").replace(csvChars, ' ') == "a b c");
+	S2_TEST(s2::stringview(",;x,;").trim(csvChars) == "x");
+
+	s2::string fields = "1,2;;3";
+	const char* expectedFields[] = { "1", "2", "", "3" };
+	int numFields = 0;
+	for (s2::stringview field : fields.split_view(csvChars)) {
+		S2_TEST(numFields < 4 && field == expectedFields[numFields]);
+		numFields++;
+	}
+	S2_TEST(numFields == 4);
+	S2_TEST(fields.split_view(csvChars, 2).len() == 2);
+	S2_TEST(fields.split_view(s2::charset()).len() == 0);
+	str = "foo\tbar";
 
 	S2_TEST(str.substr(4) == "bar");
 	S2_TEST(str.substr(0, 3) == "foo");
@@ -164,6 +249,34 @@ void test_string()
 	str = "a b-c";
 	S2_TEST(str.replace(" -", '_') == "a_b_c");
 
+	str = "{name} has {count} items, {name}!";
+	S2_TEST(str.replace("{name}", "Scratch") == "Scratch has {count} items, Scratch!");
+	S2_TEST(str.replace("{name}", "") == " has {count} items, !");
+	S2_TEST(str.replace("{", "{{") == "{{name} has {{count} items, {{name}!");
+	S2_TEST(str.replace("aaa", "b") == str);
+	str = "aaaa";
+	S2_TEST(str.replace("aa", "b") == "bb");
+	S2_TEST(str.replace("aaa", "b") == "ba");
+
+	str = "{name} has {count} items, {name}!";
+	str = str.replace_all({ { "{name}", "Scratch" }, { "{count}", "3" } });
+	S2_TEST(str == "Scratch has 3 items, Scratch!");
+	str = "abba";
+	S2_TEST(str.replace_all({ { "a", "b" }, { "b", "a" } }) == "baab");
+	S2_TEST(str.replace_all({ { "ab", "1" }, { "a", "2" } }) == "1b2");
+	S2_TEST(str.replace_all({ { "a", "2" }, { "ab", "1" } }) == "2bb2");
+	S2_TEST(str.replace_all({ { "bb", "" }, { "", "x" } }) == "aa");
+	S2_TEST(str.replace_all({}) == "abba");
+
+	s2::string::replacepair manyPairs[10];
+	const char* manyFinds[10] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+	const char* manyReplaces[10] = { "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine" };
+	for (int i = 0; i < 10; i++) {
+		manyPairs[i] = { manyFinds[i], manyReplaces[i] };
+	}
+	str = "9 8, 76 5";
+	S2_TEST(str.replace_all(manyPairs, 10) == "nine eight, sevensix five");
+
 	str = "12.3";
 	S2_TEST(str.as_int() == 12);
 	S2_TEST(str.as_large_int() == 12);
@@ -178,4 +291,544 @@ void test_string()
 	S2_TEST(strEmpty2.allocsize() == 0);
 	strEmpty2.append("test");
 	S2_TEST(strEmpty2 == "test");
+
+	s2::string strShort = "tag:value";
+	const char* pShortObject = (const char*)&strShort;
+	S2_TEST(strShort.allocsize() == S2_STRING_LOCAL_SIZE);
+	S2_TEST(strShort.c_str() >= pShortObject && strShort.c_str() < pShortObject + sizeof(strShort));
+	strShort.append("-and-more");
+	S2_TEST(strShort == "tag:value-and-more");
+	S2_TEST(strShort.c_str() >= pShortObject && strShort.c_str() < pShortObject + sizeof(strShort));
+	strShort.append(" and then some more so it goes to the heap");
+	S2_TEST(strShort == "tag:value-and-more and then some more so it goes to the heap");
+	S2_TEST(strShort.allocsize() > S2_STRING_LOCAL_SIZE);
+	S2_TEST(!(strShort.c_str() >= pShortObject && strShort.c_str() < pShortObject + sizeof(strShort)));
+
+	// Building, copying, assigning and appending short strings never allocates
+	int numMallocs = _numMallocs;
+	{
+		s2::string strA = "short";
+		s2::string strB(strA);
+		s2::string strC;
+		strC = strA;
+		strC = "other";
+		strC.append(" text");
+		strC += strB;
+		strC.append('!');
+		s2::string strD(static_cast<s2::string&&>(strB));
+		strD = strC;
+		S2_TEST(strC == "other textshort!");
+		S2_TEST(strD == strC);
+	}
+	S2_TEST(_numMallocs == numMallocs);
+
+	// Strings that don't fit do allocate
+	s2::string strHeap("this string is long enough to not fit in the object");
+	S2_TEST(_numMallocs > numMallocs);
+
+	s2::string strLocalLimit("12345678901234567890123");
+	S2_TEST(strLocalLimit.allocsize() == S2_STRING_LOCAL_SIZE);
+	strLocalLimit.append('4');
+	S2_TEST(strLocalLimit == "123456789012345678901234");
+	S2_TEST(strLocalLimit.allocsize() > S2_STRING_LOCAL_SIZE);
+
+	s2::string strSetLength;
+	strSetLength.ensure_memory(6);
+	strcpy((char*)strSetLength.c_str(), "hello");
+	strSetLength.set_length_unsafe(5);
+	S2_TEST(strSetLength == "hello");
+	S2_TEST(strSetLength.len() == 5);
+
+	s2::string strMoveSource = "this string is long enough to be on the heap";
+	const char* pMoveBuffer = strMoveSource.c_str();
+	s2::string strMoved(static_cast<s2::string&&>(strMoveSource));
+	S2_TEST(strMoved == "this string is long enough to be on the heap");
+	S2_TEST(strMoved.c_str() == pMoveBuffer);
+	S2_TEST(strMoveSource.is_null());
+	S2_TEST(strMoveSource.len() == 0);
+
+	strMoveSource = static_cast<s2::string&&>(strMoved);
+	S2_TEST(strMoveSource.c_str() == pMoveBuffer);
+	S2_TEST(strMoved.is_null());
+
+	strMoved = s2::string("short");
+	S2_TEST(strMoved == "short");
+	S2_TEST(strMoved.len() == 5);
+
+	s2::string strSteal;
+	strSteal.append(static_cast<s2::string&&>(strMoveSource));
+	S2_TEST(strSteal.c_str() == pMoveBuffer);
+	S2_TEST(strMoveSource.is_null());
+	strSteal.append(s2::string("!"));
+	S2_TEST(strSteal == "this string is long enough to be on the heap!");
+
+	s2::string strPrefix = "prefix";
+	s2::string strId = "1234567890";
+	s2::string strField = "a_field_name_that_is_long";
+	s2::string strKey = strPrefix + ":" + strId + ":" + strField;
+	S2_TEST(strKey == "prefix:1234567890:a_field_name_that_is_long");
+	S2_TEST(strPrefix == "prefix");
+	S2_TEST("<" + (strPrefix + ">") == "<prefix>");
+	S2_TEST("<" + strPrefix == "<prefix");
+	S2_TEST(s2::string() + s2::string() == "");
+	S2_TEST(strPrefix + s2::string(":") + strId == "prefix:1234567890");
+
+	S2_TEST(strPrefix.substr(0, 0) + 'x' == "x");
+	S2_TEST(strPrefix + '.' + strId == "prefix.1234567890");
+	S2_TEST(strPrefix + s2::string("_suffix_long_enough_for_the_heap") == "prefix_suffix_long_enough_for_the_heap");
+	S2_TEST(strcmp((strPrefix + "/").c_str(), "prefix/") == 0);
+	S2_TEST(s2::string("prefix/a").startswith(strPrefix + "/"));
+
+	// Chained concatenations append into the buffer of the first temporary
+	s2::string strReuse = "this string is long enough to be on the heap";
+	strReuse.ensure_memory(128);
+	const char* pReuse = strReuse.c_str();
+	s2::string strReused = static_cast<s2::string&&>(strReuse) + ":" + strId + '!' + s2::string("?");
+	S2_TEST(strReused == "this string is long enough to be on the heap:1234567890!?");
+	S2_TEST(strReused.c_str() == pReuse);
+
+	// concat() mixes strings, views, C strings and characters, and allocates once
+	s2::stringview viewId(strId.c_str(), 4);
+	const char* szSep = "::";
+	numMallocs = _numMallocs;
+	strKey = s2::concat(strPrefix, ':', viewId, szSep, strField, '!');
+	S2_TEST(_numMallocs == numMallocs + 1);
+	S2_TEST(strKey == "prefix:1234::a_field_name_that_is_long!");
+	S2_TEST(strKey.len() == 39);
+	S2_TEST(s2::concat(viewId, "-", viewId) == "1234-1234");
+	S2_TEST(s2::concat(strPrefix, (const char*)nullptr).len() == 6);
+	S2_TEST(s2::concat(s2::stringview(), "").is_null());
+	S2_TEST(s2::concat({ "a", viewId, strPrefix }) == "a1234prefix");
+
+	s2::string strLong;
+	for (int i = 0; i < 20; i++) {
+		strLong.append("abcabd-xyz, ");
+	}
+	strLong.append("needle abcabc");
+	S2_TEST(strLong.indexof('n') == 240);
+	S2_TEST(strLong.indexof("needle") == 240);
+	S2_TEST(strLong.indexof("abcabc") == 247);
+	S2_TEST(strLong.indexof("abcabe") == -1);
+	S2_TEST(strLong.lastindexof('-') == 6 + 12 * 19);
+	S2_TEST(strLong.lastindexof("abd") == 3 + 12 * 19);
+	S2_TEST(strLong.lastindexof("abc") == 250);
+	S2_TEST(strLong.lastindexof("abca") == 247);
+	S2_TEST(strLong.lastindexof("xyz, abcabd") == 7 + 12 * 18);
+	S2_TEST(strLong.lastindexof("zzz") == -1);
+	S2_TEST(strLong.contains("abd-"));
+	S2_TEST(!strLong.contains("abc-"));
+	S2_TEST(strLong.startswith("abcabd-xyz, abcabd"));
+	S2_TEST(!strLong.startswith("abcabd-xyz, abcabc"));
+	S2_TEST(strLong.endswith("needle abcabc"));
+	S2_TEST(!str.endswith("this string is longer than the original string"));
+
+	// Compare the search functions against a naive search at every offset and length, so that all block boundaries are hit
+	const char* haystack = "aabaaabaabbaaabaaaabababbaaabaaabaabababaaaabbbaaaabaabaabbbabaaababaab";
+	size_t haystackLen = strlen(haystack);
+	const char* needles[] = { "a", "b", "ab", "aab", "baaab", "abaaabaab", "bbb", "ccc" };
+	bool searchMatches = true;
+	for (const char* needle : needles) {
+		size_t needleLen = strlen(needle);
+		for (size_t len = 0; len <= haystackLen; len++) {
+			const char* expectFirst = nullptr;
+			const char* expectLast = nullptr;
+			for (size_t i = 0; i + needleLen <= len; i++) {
+				if (!memcmp(haystack + i, needle, needleLen)) {
+					if (expectFirst == nullptr) {
+						expectFirst = haystack + i;
+					}
+					expectLast = haystack + i;
+				}
+			}
+			if (s2::memfind(haystack, len, needle, needleLen) != expectFirst || s2::memrfind(haystack, len, needle, needleLen) != expectLast) {
+				searchMatches = false;
+			}
+			if (needleLen == 1 && (s2::memfind(haystack, len, needle[0]) != expectFirst || s2::memrfind(haystack, len, needle[0]) != expectLast)) {
+				searchMatches = false;
+			}
+		}
+	}
+	S2_TEST(searchMatches);
+
+	str = "aaab";
+	S2_TEST(str.contains_nocase("aab"));
+	S2_TEST(str.contains_nocase("AAB"));
+	S2_TEST(str.indexof_nocase("AaB") == 1);
+	S2_TEST(str.lastindexof_nocase("A") == 2);
+	S2_TEST(!str.contains_nocase("aaaa"));
+	S2_TEST(str.contains_nocase(""));
+
+	str = "Content-Type: text/plain; Content-Length: 10; content-type: text/html";
+	S2_TEST(str.indexof_nocase("CONTENT-TYPE") == 0);
+	S2_TEST(str.lastindexof_nocase("CONTENT-TYPE") == 46);
+	S2_TEST(str.indexof_nocase("content-length") == 26);
+	S2_TEST(str.indexof_nocase("Content-Type: TEXT/PLAIN; Content-Length: 10;") == 0);
+	S2_TEST(str.lastindexof_nocase("content-length: 10; CONTENT-TYPE: text/html") == 26);
+	S2_TEST(!str.contains_nocase("content-type: text/plain; content-length: 11"));
+	S2_TEST(!str.contains_nocase("[content-type]"));
+
+	s2::stringview view(str.c_str(), 24);
+	S2_TEST(view.contains_nocase("TEXT/PLAIN"));
+	S2_TEST(!view.contains_nocase("content-length"));
+	S2_TEST(view.indexof_nocase("text") == 14);
+	S2_TEST(view.lastindexof_nocase("T") == 17);
+
+	// Compare against a naive search with mixed case needles, both for short and long (Horspool) needles
+	const char* haystackCase = "aAbAaAbaABbAAaBaaaAbaBaBBaaABaaabAaBabAbaaaABbbaaAAbaAbaAbBBaBaAaBabaAB";
+	const char* needlesCase[] = { "A", "ab", "AaB", "BAAAB", "abAAABaab", "abaaabaabbaaabaaaabababbaaabaaabaa", "aAbBBaBaAaBabaAB", "aaabAaBabAbaaaABbbaaAAbaAbaAbBBaBaAaBabaAB", "ccc" };
+	size_t haystackCaseLen = strlen(haystackCase);
+	bool searchCaseMatches = true;
+	for (const char* needle : needlesCase) {
+		size_t needleLen = strlen(needle);
+		for (size_t len = 0; len <= haystackCaseLen; len++) {
+			const char* expectFirst = nullptr;
+			const char* expectLast = nullptr;
+			for (size_t i = 0; i + needleLen <= len; i++) {
+				size_t matched = 0;
+				while (matched < needleLen && tolower(haystackCase[i + matched]) == tolower(needle[matched])) {
+					matched++;
+				}
+				if (matched == needleLen) {
+					if (expectFirst == nullptr) {
+						expectFirst = haystackCase + i;
+					}
+					expectLast = haystackCase + i;
+				}
+			}
+			if (s2::memfind_nocase(haystackCase, len, needle, needleLen) != expectFirst || s2::memrfind_nocase(haystackCase, len, needle, needleLen) != expectLast) {
+				searchCaseMatches = false;
+			}
+		}
+	}
+	S2_TEST(searchCaseMatches);
+
+	// Views that are slices of a larger buffer must never read past their length
+	const char* strLine = "  key = Value  ; 1234 ; -56 ; 2.5 ; yes";
+	s2::stringview viewKey(strLine, 7);
+	S2_TEST(viewKey.len() == 7);
+	S2_TEST(viewKey == "  key =");
+	S2_TEST(viewKey != "  key = Value");
+	S2_TEST(viewKey.trim() == "key =");
+	S2_TEST(viewKey.trim(" =") == "key");
+	S2_TEST(viewKey.trim(" =ky") == "e");
+	S2_TEST(viewKey.trim(" =kye").len() == 0);
+	S2_TEST(viewKey.indexof('=') == 6);
+	S2_TEST(viewKey.indexof(';') == -1);
+	S2_TEST(viewKey.lastindexof(' ') == 5);
+	S2_TEST(viewKey.indexof("key") == 2);
+	S2_TEST(viewKey.lastindexof(" ") == 5);
+	S2_TEST(!viewKey.contains("Value"));
+	S2_TEST(viewKey.startswith("  k"));
+	S2_TEST(viewKey.endswith("y ="));
+	S2_TEST(!viewKey.endswith("Value"));
+	S2_TEST(viewKey.substr(2) == "key =");
+	S2_TEST(viewKey.substr(2, 3) == "key");
+	S2_TEST(viewKey.substr(-3) == "y =");
+	S2_TEST(viewKey.substr(5, 100) == " =");
+	S2_TEST(viewKey.substr(7).len() == 0);
+	S2_TEST(s2::string(viewKey) == "  key =");
+
+	S2_TEST(s2::stringview(strLine + 17, 4).as_int() == 1234);
+	S2_TEST(s2::stringview(strLine + 17, 2).as_int() == 12);
+	S2_TEST(s2::stringview(strLine + 23, 4).as_large_int() == -56);
+	S2_TEST(s2::stringview(strLine + 16, 5).as_uint() == 1234);
+	S2_TEST(s2::stringview(strLine + 30, 3).as_double() == 2.5);
+	S2_TEST(s2::stringview(strLine + 30, 1).as_float() == 2.0f);
+	S2_TEST(s2::stringview(strLine + 36, 3).as_bool());
+	S2_TEST(!s2::stringview(strLine + 8, 5).as_bool());
+
+	// Comparisons are lexicographic over bytes, with shorter prefixes coming first
+	s2::stringview viewAbc("abcdef", 3);
+	S2_TEST(viewAbc == s2::string("abc"));
+	S2_TEST(viewAbc == s2::stringview("abcxyz", 3));
+	S2_TEST(viewAbc < "abcd");
+	S2_TEST(viewAbc < s2::string("abd"));
+	S2_TEST(viewAbc > "ab");
+	S2_TEST(viewAbc >= "abc");
+	S2_TEST(viewAbc <= s2::stringview("abc"));
+	S2_TEST(viewAbc.compare("abb") > 0);
+	S2_TEST(viewAbc.compare(s2::stringview("abcdef", 3)) == 0);
+
+	// Hashes should match the default hashers for the same text
+	S2_TEST(viewAbc.hash() == s2::default_hashers_hashtable::hash("abc"));
+	S2_TEST(s2::stringview(strLine, 30).hash() == s2::stringview(s2::string(strLine).substr(0, 30)).hash());
+	S2_TEST(s2::stringview("").hash() == s2::default_hashers_hashtable::hash(""));
+
+	// Strings compare by length and bytes, so embedded null characters count
+	s2::string strAbc = "abc";
+	s2::string strNul("ab\0c", 4);
+	s2::string strNul2("ab\0d", 4);
+	S2_TEST(strAbc == s2::string("abc"));
+	S2_TEST(strNul != strNul2);
+	S2_TEST(strNul == s2::string("ab\0c", 4));
+	S2_TEST(strNul != "ab");
+	S2_TEST(strNul == s2::stringview("ab\0c", 4));
+	S2_TEST(s2::string() == "");
+	S2_TEST(s2::string() == s2::string(""));
+	S2_TEST(s2::string() == (const char*)nullptr);
+	S2_TEST(strAbc.compare("abd") < 0);
+	S2_TEST(strAbc.compare("ab") > 0);
+	S2_TEST(strAbc.compare(s2::string("abc")) == 0);
+	S2_TEST(strNul.compare(strNul2) < 0);
+	S2_TEST(s2::string().compare("") == 0);
+	S2_TEST(strAbc < "abd" && strAbc <= "abc" && strAbc > "ab" && strAbc >= "abc");
+	S2_TEST(strNul < strNul2 && strNul2 > strNul && !(strNul < strNul));
+	S2_TEST("abb" < strAbc && "abd" > strAbc && "abc" <= strAbc && "abc" >= strAbc && "abd" != strAbc);
+	S2_TEST(strAbc < s2::stringview("abcd"));
+
+	S2_TEST(strAbc.hash() == s2::default_hashers_hashtable::hash("abc"));
+	S2_TEST(s2::string().hash() == s2::default_hashers_hashtable::hash(""));
+	S2_TEST(strNul.hash() != strNul2.hash());
+	S2_TEST(s2::stringhasher::hash(strAbc) == s2::stringhasher::hash("abc"));
+
+	s2::hashtable<s2::string, int, s2::stringhasher> strTable;
+	strTable[strAbc] = 1;
+	strTable[strNul] = 2;
+	strTable[strNul2] = 3;
+	S2_TEST(strTable.len() == 3);
+	S2_TEST(strTable["abc"] == 1);
+	S2_TEST(strTable[strNul] == 2);
+
+	s2::list<s2::string> strList = { "pear", "apple", "banana", "app" };
+	strList.sort();
+	S2_TEST(strList[0] == "app" && strList[1] == "apple" && strList[2] == "banana" && strList[3] == "pear");
+
+	// Number parsing reports where it stopped and whether it failed
+	const char* strNumbers = "12345678901234567890 -9223372036854775808 4294967296 3.25e2x -.5 1e 0x10";
+	const char* strNumbersEnd = strNumbers + strlen(strNumbers);
+	uint64_t parsedUint = 0;
+	s2::parseresult res = s2::parse_number(strNumbers, strNumbersEnd, parsedUint);
+	S2_TEST(res.error == s2::parseerror::none);
+	S2_TEST(parsedUint == 12345678901234567890llu);
+	S2_TEST(res.ptr == strNumbers + 20);
+	int64_t parsedInt = 0;
+	res = s2::parse_number(strNumbers, strNumbersEnd, parsedInt);
+	S2_TEST(res.error == s2::parseerror::out_of_range);
+	S2_TEST(res.ptr == strNumbers + 20);
+	S2_TEST(parsedInt == 0);
+	res = s2::parse_number(strNumbers + 21, strNumbersEnd, parsedInt);
+	S2_TEST(res && parsedInt == INT64_MIN);
+	uint32_t parsedUint32 = 0;
+	res = s2::parse_number(strNumbers + 42, strNumbersEnd, parsedUint32);
+	S2_TEST(res.error == s2::parseerror::out_of_range);
+	S2_TEST(s2::parse_number(strNumbers + 21, strNumbersEnd, parsedUint32).error == s2::parseerror::invalid);
+	int32_t parsedInt32 = 0;
+	res = s2::parse_number(strNumbers + 42, strNumbers + 51, parsedInt32);
+	S2_TEST(res && parsedInt32 == 429496729);
+	double parsedDouble = 0;
+	res = s2::parse_number(strNumbers + 53, strNumbersEnd, parsedDouble);
+	S2_TEST(res && parsedDouble == 325.0);
+	S2_TEST(*res.ptr == 'x');
+	res = s2::parse_number(strNumbers + 61, strNumbersEnd, parsedDouble);
+	S2_TEST(res && parsedDouble == -0.5);
+	res = s2::parse_number(strNumbers + 65, strNumbersEnd, parsedDouble);
+	S2_TEST(res && parsedDouble == 1.0);
+	S2_TEST(*res.ptr == 'e');
+	res = s2::parse_number(strNumbers + 68, strNumbersEnd, parsedDouble);
+	S2_TEST(res && parsedDouble == 0.0);
+	S2_TEST(*res.ptr == 'x');
+	S2_TEST(s2::parse_number(strNumbers + 20, strNumbersEnd, parsedDouble).error == s2::parseerror::invalid);
+	S2_TEST(s2::stringview("1e999").parse(parsedDouble).error == s2::parseerror::out_of_range);
+	S2_TEST(s2::stringview("-Infinity").parse(parsedDouble) && parsedDouble < -DBL_MAX);
+	S2_TEST(s2::stringview("nan").parse(parsedDouble) && parsedDouble != parsedDouble);
+	float parsedFloat = 0;
+	S2_TEST(s2::string("0.1").parse(parsedFloat) && parsedFloat == 0.1f);
+	S2_TEST(s2::string("16777217").parse(parsedFloat) && parsedFloat == 16777216.0f);
+
+	// Compare against strtod and strtof, which are correctly rounded, for both the fast and the slow paths
+	const char* strDecimals[] = {
+		"0", "-0", "1", "0.1", "0.3", "123.456", "1e22", "1e23", "9007199254740993", "9007199254740992e3",
+		"123456789012345678901234567890", "0.000000000000000000000000000001", "2.2250738585072014e-308",
+		"4.9e-324", "1.7976931348623157e308", "3.4028235e38", "1.17549435e-38", "0.1000000000000000055511151231257827",
+		"7.038531e-26", "12345678.12345678", "0.0000000012345678901234567", "99999999999999999999e-20",
+	};
+	bool decimalsMatch = true;
+	for (const char* decimal : strDecimals) {
+		size_t decimalLen = strlen(decimal);
+		if (!s2::parse_number(decimal, decimal + decimalLen, parsedDouble) || parsedDouble != strtod(decimal, nullptr)) {
+			decimalsMatch = false;
+		}
+		float expectFloat = strtof(decimal, nullptr);
+		res = s2::parse_number(decimal, decimal + decimalLen, parsedFloat);
+		if (expectFloat > FLT_MAX ? res.error != s2::parseerror::out_of_range : (!res || parsedFloat != expectFloat)) {
+			decimalsMatch = false;
+		}
+	}
+	uint64_t seed = 1234;
+	for (int i = 0; i < 20000; i++) {
+		char buffer[64];
+		seed = seed * 6364136223846793005llu + 1442695040888963407llu;
+		uint64_t digits = seed >> 11;
+		seed = seed * 6364136223846793005llu + 1442695040888963407llu;
+		int exponent = (int)(seed >> 33) % 80 - 40;
+		int decimals = (int)(seed >> 40) % 20;
+		snprintf(buffer, sizeof(buffer), "%llu.%0*llue%d", (unsigned long long)(digits >> (i % 50)), decimals, (unsigned long long)(digits % 1000003), exponent);
+		if (!s2::parse_number(buffer, buffer + strlen(buffer), parsedDouble) || parsedDouble != strtod(buffer, nullptr)) {
+			decimalsMatch = false;
+		}
+		float expectFloat = strtof(buffer, nullptr);
+		res = s2::parse_number(buffer, buffer + strlen(buffer), parsedFloat);
+		if (expectFloat > FLT_MAX ? res.error != s2::parseerror::out_of_range : (!res || parsedFloat != expectFloat)) {
+			decimalsMatch = false;
+		}
+	}
+	S2_TEST(decimalsMatch);
+
+	// Parse a column of numbers at once
+	const char* strColumn = "10\r\n 20\n-30 \n40\n";
+	int32_t column[8];
+	size_t columnCount = 0;
+	res = s2::parse_numbers(strColumn, strColumn + strlen(strColumn), '\n', column, 8, columnCount);
+	S2_TEST(res.error == s2::parseerror::none);
+	S2_TEST(columnCount == 4);
+	S2_TEST(column[0] == 10 && column[1] == 20 && column[2] == -30 && column[3] == 40);
+	res = s2::parse_numbers(strColumn, strColumn + strlen(strColumn), '\n', column, 2, columnCount);
+	S2_TEST(res && columnCount == 2);
+	S2_TEST(res.ptr == strColumn + 8);
+	const char* strRow = "1.5, 2.5,x";
+	double row[4];
+	res = s2::parse_numbers(strRow, strRow + strlen(strRow), ',', row, 4, columnCount);
+	S2_TEST(res.error == s2::parseerror::invalid);
+	S2_TEST(columnCount == 2 && row[1] == 2.5);
+	S2_TEST(res.ptr == strRow + 9);
+	const char* strSpaced = "1 2\t3";
+	res = s2::parse_numbers(strSpaced, strSpaced + strlen(strSpaced), ' ', column, 8, columnCount);
+	S2_TEST(res.error == s2::parseerror::invalid);
+	S2_TEST(columnCount == 2);
+
+	// Numbers are formatted straight into the string
+	s2::string strFormatted;
+	strFormatted.append_int(0);
+	strFormatted.append(' ');
+	strFormatted.append_int(INT64_MIN);
+	strFormatted.append(' ');
+	strFormatted.append_uint(UINT64_MAX);
+	strFormatted.append(' ');
+	strFormatted.append_hex(0xDEADBEEF);
+	strFormatted.append(' ');
+	strFormatted.append_hex(0xABC, true);
+	strFormatted.append(' ');
+	strFormatted.append_hex(0);
+	S2_TEST(strFormatted == "0 -9223372036854775808 18446744073709551615 deadbeef ABC 0");
+
+	s2::string strSmall = "n=";
+	strSmall.append_int(-42);
+	S2_TEST(strSmall == "n=-42");
+	S2_TEST(strSmall.allocsize() == S2_STRING_LOCAL_SIZE);
+
+	const double formatDoubles[] = { 0.0, -0.0, 1.0, -2.5, 0.1, 1.0 / 3.0, 123456.789, 1e21, 1e20, 1e-6, 1e-7, 5e-324, DBL_MAX, 1.5e300, 2.0e-300 };
+	const char* formatExpected[] = { "0", "-0", "1", "-2.5", "0.1", "0.3333333333333333", "123456.789", "1e+21", "100000000000000000000", "0.000001", "1e-7", "5e-324", "1.7976931348623157e+308", "1.5e+300", "2e-300" };
+	bool formatMatches = true;
+	for (size_t i = 0; i < sizeof(formatDoubles) / sizeof(double); i++) {
+		s2::string strDouble;
+		strDouble.append_double(formatDoubles[i]);
+		if (strDouble != formatExpected[i]) {
+			formatMatches = false;
+		}
+	}
+	S2_TEST(formatMatches);
+
+	// Formatted doubles must always parse back to exactly the same value, and never need more than 17 digits
+	bool formatRoundTrips = true;
+	seed = 5678;
+	for (int i = 0; i < 100000; i++) {
+		seed = seed * 6364136223846793005llu + 1442695040888963407llu;
+		uint64_t bits = seed;
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		if (value != value || value > DBL_MAX || value < -DBL_MAX) {
+			continue;
+		}
+		char buffer[s2::max_number_length + 1];
+		size_t len = s2::format_double(buffer, value);
+		buffer[len] = '\0';
+		size_t digits = 0;
+		for (size_t j = 0; j < len && buffer[j] != 'e'; j++) {
+			if (buffer[j] >= '0' && buffer[j] <= '9') {
+				digits++;
+			}
+		}
+		if (strtod(buffer, nullptr) != value || (digits > 17 && strchr(buffer, 'e') != nullptr)) {
+			formatRoundTrips = false;
+		}
+	}
+	S2_TEST(formatRoundTrips);
+
+	// Floats are written at float precision instead of as the double they widen to, and never need more than 9 digits
+	const float formatFloats[] = { 0.1f, -2.5f, 1.0f / 3.0f, 1e-45f, FLT_MAX, 3e38f, 1e-7f, 123456.79f };
+	const char* formatFloatsExpected[] = { "0.1", "-2.5", "0.33333334", "1e-45", "3.4028235e+38", "3e+38", "1e-7", "123456.79" };
+	bool formatFloatMatches = true;
+	for (size_t i = 0; i < sizeof(formatFloats) / sizeof(float); i++) {
+		s2::string strFloat;
+		strFloat.append_float(formatFloats[i]);
+		if (strFloat != formatFloatsExpected[i]) {
+			formatFloatMatches = false;
+		}
+	}
+	S2_TEST(formatFloatMatches);
+
+	bool formatFloatRoundTrips = true;
+	for (int i = 0; i < 100000; i++) {
+		seed = seed * 6364136223846793005llu + 1442695040888963407llu;
+		uint32_t bits = (uint32_t)(seed >> 32);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		if (value != value || value > FLT_MAX || value < -FLT_MAX) {
+			continue;
+		}
+		char buffer[s2::max_number_length + 1];
+		size_t len = s2::format_float(buffer, value);
+		buffer[len] = '\0';
+		size_t digits = 0;
+		for (size_t j = 0; j < len && buffer[j] != 'e'; j++) {
+			if (buffer[j] >= '0' && buffer[j] <= '9') {
+				digits++;
+			}
+		}
+		if (strtof(buffer, nullptr) != value || (digits > 9 && strchr(buffer, 'e') != nullptr)) {
+			formatFloatRoundTrips = false;
+		}
+	}
+	S2_TEST(formatFloatRoundTrips);
+
+	// Case conversion only touches ASCII letters
+	s2::string strCase = "Hello, World! \xC3\x84\xC3\xB6 [@`{]";
+	S2_TEST(strCase.tolower() == "hello, world! \xC3\x84\xC3\xB6 [@`{]");
+	S2_TEST(strCase.toupper() == "HELLO, WORLD! \xC3\x84\xC3\xB6 [@`{]");
+	S2_TEST(strCase == "Hello, World! \xC3\x84\xC3\xB6 [@`{]");
+	strCase.make_upper();
+	S2_TEST(strCase == "HELLO, WORLD! \xC3\x84\xC3\xB6 [@`{]");
+	strCase.make_lower();
+	S2_TEST(strCase == "hello, world! \xC3\x84\xC3\xB6 [@`{]");
+	S2_TEST(s2::string().tolower().is_null());
+
+	char caseBuffer[8] = "xxxxxxx";
+	s2::stringview("Content-Type", 7).lower_to(caseBuffer);
+	S2_TEST(!strcmp(caseBuffer, "content"));
+	s2::stringview("content-type", 4).upper_to(caseBuffer);
+	S2_TEST(!strcmp(caseBuffer, "CONTent"));
+
+	// Compare all byte values against a simple loop, at every length and offset to cover the vector tails
+	char caseInput[256 + 64];
+	char caseLower[256 + 64];
+	char caseUpper[256 + 64];
+	for (int i = 0; i < (int)sizeof(caseInput); i++) {
+		caseInput[i] = (char)(i * 7);
+	}
+	bool caseMatches = true;
+	for (size_t offset = 0; offset < 4; offset++) {
+		for (size_t len = 0; len + offset <= sizeof(caseInput); len += 13) {
+			s2::memlower(caseLower, caseInput + offset, len);
+			s2::memupper(caseUpper, caseInput + offset, len);
+			for (size_t i = 0; i < len; i++) {
+				char c = caseInput[offset + i];
+				char lower = (c >= 'A' && c <= 'Z') ? (char)(c + 32) : c;
+				char upper = (c >= 'a' && c <= 'z') ? (char)(c - 32) : c;
+				if (caseLower[i] != lower || caseUpper[i] != upper) {
+					caseMatches = false;
+				}
+			}
+		}
+	}
+	S2_TEST(caseMatches);
 }
@@ -0,0 +1,88 @@
+#include "allocs.h"
+
+#include <s2stringbuilder.h>
+
+#include <s2test.h>
+
+struct StringWriter
+{
+	s2::string output;
+	int numWrites = 0;
+
+	void write(const void* buffer, size_t size)
+	{
+		output.append((const char*)buffer, size);
+		numWrites++;
+	}
+};
+
+void test_stringbuilder()
+{
+	s2::test_group("stringbuilder");
+
+	s2::stringbuilder empty;
+	S2_TEST(empty.len() == 0);
+	S2_TEST(empty.to_string() == "");
+	S2_TEST(empty.segments(nullptr, 0) == 0);
+
+	s2::stringbuilder sb(16);
+	sb.append("Hello");
+	sb.append(',');
+	sb.append(s2::string(" world"));
+	sb.append(s2::stringview("! and some more", 1));
+	S2_TEST(sb.len() == 13);
+	S2_TEST(sb.to_string() == "Hello, world!");
+
+	sb.append(" This sentence is longer than a single chunk.");
+	S2_TEST(sb.to_string() == "Hello, world! This sentence is longer than a single chunk.");
+	S2_TEST(sb.len() == 58);
+
+	s2::stringview segments[8];
+	size_t numSegments = sb.segments(segments, 8);
+	S2_TEST(numSegments == 4);
+	S2_TEST(segments[0].len() == 16);
+	S2_TEST(segments[3].len() == 10);
+	S2_TEST(sb.segments(segments, 2) == 4);
+
+	StringWriter writer;
+	sb.write_to(writer);
+	S2_TEST(writer.output == sb.to_string());
+	S2_TEST(writer.numWrites == 4);
+
+	sb.clear();
+	S2_TEST(sb.len() == 0);
+	S2_TEST(sb.to_string() == "");
+
+	sb.appendf("%d-%s", 10, "abc");
+	S2_TEST(sb.to_string() == "10-abc");
+	sb.appendf("%s", "this is formatted across chunks");
+	S2_TEST(sb.to_string() == "10-abcthis is formatted across chunks");
+	S2_TEST(sb.len() == 37);
+
+	sb.clear();
+	sb.append_int(0);
+	sb.append(' ');
+	sb.append_int(-1234567890123);
+	sb.append(' ');
+	sb.append_int(INT64_MIN);
+	sb.append(' ');
+	sb.append_uint(UINT64_MAX);
+	S2_TEST(sb.to_string() == "0 -1234567890123 -9223372036854775808 18446744073709551615");
+
+	sb.clear();
+	sb.append_double(0.1);
+	sb.append(' ');
+	sb.append_double(-2.5);
+	sb.append(' ');
+	sb.append_double(1.0 / 3.0);
+	S2_TEST(sb.to_string() == "0.1 -2.5 0.3333333333333333");
+
+	sb.clear();
+	sb.append("abc");
+	sb.reserve(64);
+	numSegments = sb.segments(segments, 8);
+	S2_TEST(numSegments == 1);
+	sb.append("0123456789012345678901234567890123456789");
+	S2_TEST(sb.segments(segments, 8) == 2);
+	S2_TEST(segments[1].len() == 40);
+}
@@ -1,3 +1,5 @@
+#include "allocs.h"
+
 #include <s2stringpath.h>
 
 #include <s2test.h>
@@ -45,6 +47,58 @@ void test_stringpath()
 	S2_TEST(s2::path::join("", "/foo") == "/foo");
 	S2_TEST(s2::path::join("", "") == "");
 
+	// Joining many paths gives the same result as joining them two at a time
+	S2_TEST(s2::path::join("foo", "bar", "baz") == "foo/bar/baz");
+	S2_TEST(s2::path::join({ "hello", "/world/", "foo.txt" }) == "hello/world/foo.txt");
+	S2_TEST(s2::path::join({ "", "/foo", "", "bar\\" }) == "/foo/bar\\");
+	S2_TEST(s2::path::join({ "foo" }) == "foo");
+	S2_TEST(s2::path::join({}) == "");
+	s2::string joinRoot = "C:\\root\\";
+	S2_TEST(s2::path::join(joinRoot, s2::stringview("dir/x", 3), "a", "b", "c.txt") == "C:\\root\\dir/a/b/c.txt");
+	const char* joinParts[] = { "", "a", "/", "/b", "c/", "\\d" };
+	bool joinOk = true;
+	for (const char* a : joinParts) {
+		for (const char* b : joinParts) {
+			for (const char* c : joinParts) {
+				joinOk = joinOk && s2::path::join({ a, b, c }) == s2::path::join(s2::path::join(a, b), c);
+			}
+		}
+	}
+	S2_TEST(joinOk);
+
+	s2::path::builder builder("root");
+	builder.push("a");
+	builder.push("/b/");
+	S2_TEST(builder.str() == "root/a/b/");
+	S2_TEST(builder.depth() == 2);
+	builder.push("c.txt");
+	S2_TEST(builder.str() == "root/a/b/c.txt");
+	const char* builderBuffer = builder.c_str();
+	builder.pop();
+	builder.pop();
+	S2_TEST(builder.str() == "root/a");
+	builder.push("d/e");
+	S2_TEST(builder.str() == "root/a/d/e");
+	S2_TEST(builder.c_str() == builderBuffer);
+	S2_TEST(s2::path::getFileNameView(builder) == "e");
+	builder.clear();
+	S2_TEST(builder.str() == "root");
+	S2_TEST(builder.depth() == 0);
+	builder.pop();
+	S2_TEST(builder.str() == "root");
+
+	s2::path::builder relative;
+	for (int i = 0; i < 20; i++) {
+		relative.push("dir");
+	}
+	S2_TEST(relative.len() == 20 * 4 - 1);
+	for (int i = 0; i < 19; i++) {
+		relative.pop();
+	}
+	S2_TEST(relative.str() == "dir");
+	relative.pop();
+	S2_TEST(relative.str() == "");
+
 	S2_TEST(s2::path::equals("foo/bar/hello.txt", "foo\\bar\\hello.txt", true));
 	S2_TEST(s2::path::equals("foo/bar/Hello.txt", "foo\\bar\\hello.txt", false));
 	S2_TEST(!s2::path::equals("foo/bar/Helloo.txt", "foo\\bar\\hello.txt", false));
@@ -57,4 +111,50 @@ void test_stringpath()
 	S2_TEST(s2::path::getDirectoryName("hello/") == "hello/");
 	S2_TEST(s2::path::getDirectoryName("hello") == "");
 	S2_TEST(s2::path::getDirectoryName("") == "");
+	S2_TEST(s2::path::getDirectoryName("hello\\world.txt") == "hello\\");
+
+	S2_TEST(s2::path::getFileName("hello/world/foo.txt") == "foo.txt");
+	S2_TEST(s2::path::getFileName("hello\\foo") == "foo");
+	S2_TEST(s2::path::getFileName("hello/") == "");
+	S2_TEST(s2::path::getFileNameWithoutExtension("hello/world/foo.tar.gz") == "foo.tar");
+	S2_TEST(s2::path::getFileNameWithoutExtension("test.zip/hello") == "hello");
+
+	// Views point into the original path, which doesn't have to be null-terminated
+	s2::stringview pathView("dir.d/sub/file.txt.bak", 18);
+	S2_TEST(s2::path::getExtensionView(pathView) == ".txt");
+	S2_TEST(s2::path::getExtensionView(pathView).c_str() == pathView.c_str() + 14);
+	S2_TEST(s2::path::getFileNameView(pathView) == "file.txt");
+	S2_TEST(s2::path::getDirectoryNameView(pathView) == "dir.d/sub/");
+	S2_TEST(s2::path::getExtensionView("dir.d/file") == "");
+	S2_TEST(s2::path::getDirectoryNameView("file") == "");
+	S2_TEST(!s2::path::hasExtension(s2::stringview("file.txt", 4)));
+
+	S2_TEST(s2::path::normalize("foo/./bar//../baz") == "foo/baz");
+	S2_TEST(s2::path::normalize("foo\\bar\\..\\baz\\") == "foo/baz/");
+	S2_TEST(s2::path::normalize("/a/b/../../..") == "/");
+	S2_TEST(s2::path::normalize("/../a") == "/a");
+	S2_TEST(s2::path::normalize("../a/../../b") == "../../b");
+	S2_TEST(s2::path::normalize("a/..") == ".");
+	S2_TEST(s2::path::normalize("./") == ".");
+	S2_TEST(s2::path::normalize("//") == "/");
+	S2_TEST(s2::path::normalize("a/b/.") == "a/b");
+	S2_TEST(s2::path::normalize("...//..a/b..") == ".../..a/b..");
+	S2_TEST(s2::path::normalize("") == "");
+
+	const char* expectedComponents[] = { "usr", "..", "lib", "x.so" };
+	size_t numComponents = 0;
+	bool componentsOk = true;
+	s2::pathview components("/usr//..\\lib/x.so/");
+	for (s2::stringview component : components) {
+		componentsOk = componentsOk && numComponents < 4 && component == expectedComponents[numComponents];
+		numComponents++;
+	}
+	S2_TEST(componentsOk && numComponents == 4);
+	S2_TEST(components.len() == 4);
+	S2_TEST(components.is_absolute());
+	S2_TEST(components.is_directory());
+	S2_TEST(s2::pathview("").len() == 0);
+	S2_TEST(s2::pathview("//").len() == 0);
+	S2_TEST(!s2::pathview("a/b").is_absolute());
+	S2_TEST(s2::pathview(s2::stringview("a/bc", 3)).len() == 2);
 }
@@ -0,0 +1,142 @@
+#include "allocs.h"
+
+#include <s2utf8.h>
+
+#include <s2test.h>
+
+// A straightforward validator to compare the vectorized one against
+static bool validate_reference(const char* str, size_t len)
+{
+	size_t i = 0;
+	while (i < len) {
+		char32_t codepoint;
+		size_t size = s2::utf8_decode(str + i, len - i, codepoint);
+		if (size == 0) {
+			return false;
+		}
+		i += size;
+	}
+	return true;
+}
+
+void test_utf8()
+{
+	s2::test_group("utf8");
+
+	const char* strValid = "Hello, \xC3\xA4\xC3\xB6\xC3\xBC \xE2\x82\xAC \xF0\x9F\x98\x80!";
+	S2_TEST(s2::utf8_validate(strValid));
+	S2_TEST(s2::utf8_length(strValid) == 15);
+	S2_TEST(s2::utf8_validate(""));
+	S2_TEST(s2::utf8_length("") == 0);
+
+	// Overlong, surrogate, too large, truncated and stray continuation bytes
+	S2_TEST(!s2::utf8_validate("\xC0\xAF"));
+	S2_TEST(!s2::utf8_validate("\xE0\x80\xAF"));
+	S2_TEST(!s2::utf8_validate("\xF0\x80\x80\xAF"));
+	S2_TEST(!s2::utf8_validate("\xED\xA0\x80"));
+	S2_TEST(!s2::utf8_validate("\xF4\x90\x80\x80"));
+	S2_TEST(!s2::utf8_validate("\xF8\x88\x80\x80\x80"));
+	S2_TEST(!s2::utf8_validate("abc\xE2\x82"));
+	S2_TEST(!s2::utf8_validate("abc\x80"));
+	S2_TEST(s2::utf8_validate("\xF4\x8F\xBF\xBF"));
+	S2_TEST(s2::utf8_validate("\xED\x9F\xBF"));
+
+	char32_t codepoint = 0;
+	S2_TEST(s2::utf8_decode("\xE2\x82\xAC", 3, codepoint) == 3);
+	S2_TEST(codepoint == 0x20AC);
+	S2_TEST(s2::utf8_decode("\xE2\x82\xAC", 2, codepoint) == 0);
+	char encoded[4];
+	S2_TEST(s2::utf8_encode(encoded, 0x1F600) == 4);
+	S2_TEST(!memcmp(encoded, "\xF0\x9F\x98\x80", 4));
+	S2_TEST(s2::utf8_encode(encoded, 0xD800) == 0);
+	S2_TEST(s2::utf8_encode(encoded, 0x110000) == 0);
+
+	// Iterating code points, with invalid bytes replaced
+	const char* strMixed = "a\xC3\xA4\xFF\xE2\x82\xAC";
+	char32_t expected[] = { 'a', 0xE4, s2::utf_replacement, 0x20AC };
+	size_t numCodepoints = 0;
+	bool codepointsMatch = true;
+	for (char32_t c : s2::utf8view(strMixed)) {
+		if (numCodepoints >= 4 || c != expected[numCodepoints]) {
+			codepointsMatch = false;
+		}
+		numCodepoints++;
+	}
+	S2_TEST(codepointsMatch);
+	S2_TEST(numCodepoints == 4);
+
+	// Transcoding, with a long ASCII run to go through the vectorized paths
+	s2::string strText = "The quick brown fox jumps over the lazy dog. \xC3\xA4\xF0\x9F\x98\x80 and more text after it";
+	char16_t utf16[128];
+	char32_t utf32[128];
+	size_t len16 = s2::utf8_to_utf16(strText.c_str(), strText.len(), utf16);
+	size_t len32 = s2::utf8_to_utf32(strText.c_str(), strText.len(), utf32);
+	S2_TEST(len32 == s2::utf8_length(strText));
+	S2_TEST(len16 == len32 + 1);
+	S2_TEST(utf16[0] == 'T');
+	S2_TEST(utf16[45] == 0xE4);
+	S2_TEST(utf16[46] == 0xD83D && utf16[47] == 0xDE00);
+	S2_TEST(utf32[46] == 0x1F600);
+	S2_TEST(utf32[len32 - 1] == 't');
+	S2_TEST(s2::utf16_to_string(utf16, len16) == strText);
+	S2_TEST(s2::utf32_to_string(utf32, len32) == strText);
+
+	S2_TEST(s2::utf8_to_utf16("a\xC3", 2, utf16) == s2::utf_error);
+	char16_t loneSurrogate[] = { 'a', 0xDC00 };
+	S2_TEST(s2::utf16_to_string(loneSurrogate, 2).is_null());
+	char16_t cutSurrogate[] = { 'a', 0xD83D };
+	S2_TEST(s2::utf16_to_string(cutSurrogate, 2).is_null());
+	char32_t badCodepoint[] = { 0x110000 };
+	S2_TEST(s2::utf32_to_string(badCodepoint, 1).is_null());
+
+	// Compare the validator and code point counting against simple loops, with random sequences of interesting bytes at
+	// random lengths, so that errors land in every position of the vector blocks
+	const unsigned char interesting[] = {
+		'a', 'z', 0x00, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF,
+		0xE0, 0xED, 0xEE, 0xEF, 0xF0, 0xF3, 0xF4, 0xF5, 0xFF,
+	};
+	uint64_t seed = 42;
+	bool validateMatches = true;
+	bool lengthMatches = true;
+	size_t numValid = 0;
+	for (int i = 0; i < 50000; i++) {
+		char buffer[100];
+		seed = seed * 6364136223846793005llu + 1442695040888963407llu;
+		size_t len = (size_t)(seed >> 33) % sizeof(buffer);
+		bool mostlyValid = (seed >> 20) & 1;
+		for (size_t j = 0; j < len; j++) {
+			seed = seed * 6364136223846793005llu + 1442695040888963407llu;
+			if (mostlyValid && j + 4 <= len && ((seed >> 40) & 3) != 0) {
+				// Insert a valid code point, so that long valid inputs are also covered
+				size_t size = s2::utf8_encode(buffer + j, (char32_t)((seed >> 33) % 0x10FFFF));
+				if (size == 0) {
+					buffer[j] = 'x';
+					size = 1;
+				}
+				j += size - 1;
+				continue;
+			}
+			buffer[j] = (char)interesting[(seed >> 33) % sizeof(interesting)];
+		}
+
+		bool valid = validate_reference(buffer, len);
+		if (s2::utf8_validate(buffer, len) != valid) {
+			validateMatches = false;
+		}
+		if (valid) {
+			numValid++;
+			size_t count = 0;
+			for (size_t j = 0; j < len; j++) {
+				if (((unsigned char)buffer[j] & 0xC0) != 0x80) {
+					count++;
+				}
+			}
+			if (s2::utf8_length(buffer, len) != count) {
+				lengthMatches = false;
+			}
+		}
+	}
+	S2_TEST(validateMatches);
+	S2_TEST(lengthMatches);
+	S2_TEST(numValid > 1000);
+}
@@ -1,7 +1,17 @@
+#include "allocs.h"
+
 #include <s2test.h>
 
 extern void test_string();
 extern void test_stringpath();
+extern void test_stringbuilder();
+extern void test_format();
+extern void test_atom();
+extern void test_utf8();
+extern void test_sharedstring();
+extern void test_multisearch();
+extern void test_glob();
+extern void test_encoding();
 extern void test_list();
 extern void test_dict();
 extern void test_hashtable();
@@ -17,6 +27,14 @@ int main()
 
 	test_string();
 	test_stringpath();
+	test_stringbuilder();
+	test_format();
+	test_atom();
+	test_utf8();
+	test_sharedstring();
+	test_multisearch();
+	test_glob();
+	test_encoding();
 	test_list();
 	test_dict();
 	test_hashtable();